@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace plsm
+{
+/*!
+ * @brief MappedFile maps the contents of a file into (host) memory
+ *
+ * The mapping is private (copy-on-write): it can be modified in memory, but
+ * modifications are never written back to the file. It is released when the
+ * MappedFile is destroyed, so anything referring to the mapped memory (such
+ * as a Subpaving loaded from it) must not outlive the MappedFile.
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+
+	/*!
+	 * @brief Map the whole of the file at the given path
+	 */
+	explicit MappedFile(const std::string& path)
+	{
+		auto fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error("MappedFile: cannot open " + path);
+		}
+		struct stat info = {};
+		if (::fstat(fd, &info) != 0) {
+			::close(fd);
+			throw std::runtime_error("MappedFile: cannot stat " + path);
+		}
+		_size = static_cast<std::size_t>(info.st_size);
+		if (_size > 0) {
+			auto addr = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE, fd, 0);
+			if (addr == MAP_FAILED) {
+				::close(fd);
+				throw std::runtime_error("MappedFile: cannot map " + path);
+			}
+			_data = addr;
+		}
+		::close(fd);
+	}
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept :
+		_data(std::exchange(other._data, nullptr)),
+		_size(std::exchange(other._size, 0))
+	{
+	}
+
+	MappedFile&
+	operator=(const MappedFile&) = delete;
+
+	MappedFile&
+	operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other) {
+			unmap();
+			_data = std::exchange(other._data, nullptr);
+			_size = std::exchange(other._size, 0);
+		}
+		return *this;
+	}
+
+	~MappedFile()
+	{
+		unmap();
+	}
+
+	/*!
+	 * @brief Get the beginning of the mapped memory (or null if nothing is
+	 * mapped)
+	 */
+	void*
+	data() const noexcept
+	{
+		return _data;
+	}
+
+	/*!
+	 * @brief Get the size (in bytes) of the mapped memory
+	 */
+	std::size_t
+	size() const noexcept
+	{
+		return _size;
+	}
+
+private:
+	void
+	unmap() noexcept
+	{
+		if (_data != nullptr) {
+			::munmap(_data, _size);
+			_data = nullptr;
+			_size = 0;
+		}
+	}
+
+private:
+	void* _data{nullptr};
+	std::size_t _size{};
+};
+} // namespace plsm
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Kokkos_Core.hpp>
+
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+/*!
+ * @brief Prolongation relates the tiles of a Subpaving after a call to
+ * Subpaving::refine() to the tiles from before the call
+ *
+ * Each new tile has a parent tile (the tile it was refined from, or itself if
+ * it was not refined) and a weight, which is the fraction of the parent's
+ * volume covered by the new tile. Applying the prolongation to per-tile data
+ * distributes each parent's value over its children by volume, so that
+ * extensive quantities are conserved (over the selected sub-regions).
+ *
+ * @test unittest_Subpaving.cpp
+ */
+template <typename TMemSpace = DefaultMemSpace>
+class Prolongation
+{
+public:
+	//! The memory space for the prolongation data
+	using MemorySpace = TMemSpace;
+	//! Type for per-tile ids
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+	//! Type for per-tile weights
+	using WeightsView = Kokkos::View<double*, MemorySpace>;
+
+	Prolongation() = default;
+
+	/*!
+	 * @brief Construct from parent tile ids and weights (one of each per new
+	 * tile)
+	 */
+	Prolongation(const IdsView& parentTileIds, const WeightsView& weights) :
+		_parentTileIds(parentTileIds), _weights(weights)
+	{
+	}
+
+	/*!
+	 * @brief Get the number of tiles after refinement
+	 */
+	IdType
+	getNumberOfTiles() const noexcept
+	{
+		return static_cast<IdType>(_parentTileIds.size());
+	}
+
+	/*!
+	 * @brief Get the id (from before refinement) of the parent of each tile
+	 */
+	const IdsView&
+	getParentTileIds() const noexcept
+	{
+		return _parentTileIds;
+	}
+
+	/*!
+	 * @brief Get the fraction of its parent's volume covered by each tile
+	 */
+	const WeightsView&
+	getWeights() const noexcept
+	{
+		return _weights;
+	}
+
+	/*!
+	 * @brief Distribute per-tile data from the parent tiles to the new tiles
+	 *
+	 * For each new tile i, target(i) = weight(i) * source(parent(i)). Views of
+	 * rank 2 are treated as a set of components per tile.
+	 *
+	 * @param source Data for the tiles from before refinement
+	 * @param[out] target Data for the tiles after refinement; reallocated if
+	 * its size does not match
+	 */
+	template <typename TSourceView, typename TTargetView>
+	void
+	apply(const TSourceView& source, TTargetView& target) const
+	{
+		static_assert(TSourceView::rank == TTargetView::rank);
+		static_assert(TSourceView::rank == 1 || TSourceView::rank == 2);
+		using ValueType = typename TTargetView::non_const_value_type;
+
+		auto numTiles = getNumberOfTiles();
+		auto parentTileIds = _parentTileIds;
+		auto weights = _weights;
+		if constexpr (TSourceView::rank == 1) {
+			if (target.extent(0) != numTiles) {
+				Kokkos::realloc(target, numTiles);
+			}
+			auto to = target;
+			Kokkos::parallel_for(
+				"ProlongateTileData", numTiles, KOKKOS_LAMBDA(IdType i) {
+					to(i) = static_cast<ValueType>(
+						weights(i) * source(parentTileIds(i)));
+				});
+		}
+		else {
+			auto numComponents = source.extent(1);
+			if (target.extent(0) != numTiles ||
+				target.extent(1) != numComponents) {
+				Kokkos::realloc(target, numTiles, numComponents);
+			}
+			auto to = target;
+			Kokkos::parallel_for(
+				"ProlongateTileData", numTiles, KOKKOS_LAMBDA(IdType i) {
+					auto parentId = parentTileIds(i);
+					for (std::size_t k = 0; k < numComponents; ++k) {
+						to(i, k) = static_cast<ValueType>(
+							weights(i) * source(parentId, k));
+					}
+				});
+		}
+		Kokkos::fence();
+	}
+
+private:
+	//! Parent (from before refinement) of each tile
+	IdsView _parentTileIds;
+	//! Fraction of its parent's volume covered by each tile
+	WeightsView _weights;
+};
+} // namespace plsm
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+/*!
+ * @brief RefinementBudget bounds the size of a Subpaving refined by
+ * Subpaving::refine(detector, budget)
+ *
+ * Rather than refining everything the detector asks for, refinement then
+ * proceeds best-first: each batch refines by one level the tiles which the
+ * detector would refine with the highest priorities (see
+ * refine::Detector::priority()), until nothing is left to refine or the next
+ * tile would not fit within the budget.
+ *
+ * @test unittest_Subpaving.cpp
+ */
+struct RefinementBudget
+{
+	//! Largest number of tiles (unlimited by default)
+	IdType maxTiles{wildcard<IdType>};
+	//! Largest device memory size in bytes, as given by
+	//! Subpaving::getDeviceMemorySize() (unlimited by default)
+	std::uint64_t maxDeviceMemory{wildcard<std::uint64_t>};
+	//! Largest number of tiles refined together in each batch; smaller
+	//! batches follow the priorities more closely, larger ones give each
+	//! kernel more parallel work
+	IdType batchSize{1024};
+};
+} // namespace plsm
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <Kokkos_Array.hpp>
+
+#include <plsm/RefinementReport.h>
+#include <plsm/detail/Hash.h>
+
+namespace plsm
+{
+/*!
+ * @brief ItemDataHash mixes the item data of a tile into the hash which
+ * identifies the state of a Subpaving for a RefinementCache
+ *
+ * It is provided for types with unique object representations (hashed by
+ * their bytes), for float and double (hashed by their bits, with -0.0 taken
+ * as 0.0), and for Kokkos::Array of those. Other types, such as structs
+ * with floating-point members (whose padding bytes are not stable), have no
+ * hash unless ItemDataHash is specialized for them to combine their members
+ * one by one; Subpaving::refine() with a RefinementCache throws for them.
+ */
+template <typename T, typename = void>
+struct ItemDataHash
+{
+	static constexpr bool defined = false;
+};
+
+template <typename T>
+struct ItemDataHash<T,
+	std::enable_if_t<std::has_unique_object_representations_v<T>>>
+{
+	static constexpr bool defined = true;
+
+	static KOKKOS_INLINE_FUNCTION
+	std::uint64_t
+	combine(std::uint64_t hash, const T& value) noexcept
+	{
+		return detail::hashBytes(hash, &value, sizeof(T));
+	}
+};
+
+template <typename T>
+struct ItemDataHash<T,
+	std::enable_if_t<std::is_same_v<T, float> || std::is_same_v<T, double>>>
+{
+	static constexpr bool defined = true;
+
+	static KOKKOS_INLINE_FUNCTION
+	std::uint64_t
+	combine(std::uint64_t hash, T value) noexcept
+	{
+		using BitsType = std::conditional_t<sizeof(T) == sizeof(std::uint32_t),
+			std::uint32_t, std::uint64_t>;
+		// Adding zero turns -0.0 into 0.0, which compares equal to it
+		value += T{0};
+		BitsType bits;
+		std::memcpy(&bits, &value, sizeof(T));
+		return detail::hashCombine(hash, bits);
+	}
+};
+
+template <typename T, std::size_t N>
+struct ItemDataHash<Kokkos::Array<T, N>,
+	std::enable_if_t<
+		!std::has_unique_object_representations_v<Kokkos::Array<T, N>> &&
+		ItemDataHash<T>::defined>>
+{
+	static constexpr bool defined = true;
+
+	static KOKKOS_INLINE_FUNCTION
+	std::uint64_t
+	combine(std::uint64_t hash, const Kokkos::Array<T, N>& value) noexcept
+	{
+		for (std::size_t i = 0; i < N; ++i) {
+			hash = ItemDataHash<T>::combine(hash, value[i]);
+		}
+		return hash;
+	}
+};
+
+/*!
+ * @brief RefinementCache names a directory in which Subpaving::refine()
+ * stores its results, so that later runs repeating the same refinement can
+ * load the result instead
+ *
+ * Each result is stored (see Subpaving::save()) in a file named for a hash
+ * of the subpaving state before refinement and of the parameters of the
+ * detector (see refine::Detector::hash()), next to a file holding the
+ * RefinementReport of the refinement which produced it. Refinement with a
+ * detector that provides no hash is never cached.
+ *
+ * @test unittest_Subpaving.cpp
+ */
+class RefinementCache
+{
+public:
+	/*!
+	 * @brief Use the given directory, creating it if necessary
+	 */
+	explicit RefinementCache(const std::filesystem::path& directory) :
+		_directory(directory)
+	{
+		std::filesystem::create_directories(_directory);
+	}
+
+	/*!
+	 * @brief Get the cache directory
+	 */
+	const std::filesystem::path&
+	getDirectory() const noexcept
+	{
+		return _directory;
+	}
+
+	/*!
+	 * @brief Get the path of the file for the result with the given key
+	 */
+	std::filesystem::path
+	getPath(std::uint64_t key) const
+	{
+		return makePath(key, "plsm");
+	}
+
+	/*!
+	 * @brief Get the path of the file for the report of the result with the
+	 * given key
+	 */
+	std::filesystem::path
+	getReportPath(std::uint64_t key) const
+	{
+		return makePath(key, "report");
+	}
+
+	/*!
+	 * @brief Get a unique temporary path next to the given one, to be
+	 * written and then renamed to it, so that concurrent runs never see a
+	 * partially written file
+	 */
+	static std::filesystem::path
+	getTemporaryPath(const std::filesystem::path& path)
+	{
+		auto ret = path;
+		ret += "." + std::to_string(std::random_device{}()) + ".tmp";
+		return ret;
+	}
+
+	/*!
+	 * @brief Store the report of the result with the given key
+	 */
+	void
+	saveReport(std::uint64_t key, const RefinementReport& report) const
+	{
+		static_assert(std::is_trivially_copyable_v<RefinementLevelReport>);
+
+		auto path = getReportPath(key);
+		auto tmpPath = getTemporaryPath(path);
+		{
+			std::ofstream ofs(tmpPath, std::ios::binary);
+			std::uint64_t numLevels = report.levels.size();
+			std::uint64_t counts[] = {numLevels, report.balancePasses,
+				report.budgetBatches, report.budgetReached};
+			ofs.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+			ofs.write(reinterpret_cast<const char*>(report.levels.data()),
+				static_cast<std::streamsize>(
+					numLevels * sizeof(RefinementLevelReport)));
+		}
+		std::filesystem::rename(tmpPath, path);
+	}
+
+	/*!
+	 * @brief Load the report of the result with the given key
+	 *
+	 * @return The stored report, marked as loaded from the cache (with no
+	 * levels if it cannot be read)
+	 */
+	RefinementReport
+	loadReport(std::uint64_t key) const
+	{
+		RefinementReport ret;
+		ret.loadedFromCache = true;
+		std::ifstream ifs(getReportPath(key), std::ios::binary);
+		std::uint64_t counts[4]{};
+		if (!ifs.read(reinterpret_cast<char*>(counts), sizeof(counts))) {
+			return ret;
+		}
+		std::vector<RefinementLevelReport> levels(counts[0]);
+		if (!ifs.read(reinterpret_cast<char*>(levels.data()),
+				static_cast<std::streamsize>(
+					counts[0] * sizeof(RefinementLevelReport)))) {
+			return ret;
+		}
+		ret.levels = std::move(levels);
+		ret.balancePasses = counts[1];
+		ret.budgetBatches = counts[2];
+		ret.budgetReached = counts[3] != 0;
+		return ret;
+	}
+
+private:
+	std::filesystem::path
+	makePath(std::uint64_t key, const char* extension) const
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.%s",
+			static_cast<unsigned long long>(key), extension);
+		return _directory / name;
+	}
+
+	std::filesystem::path _directory;
+};
+} // namespace plsm
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+/*!
+ * @brief Measurements for one level of a call to Subpaving::refine()
+ */
+struct RefinementLevelReport
+{
+	//! The refinement level processed
+	std::size_t level{};
+
+	//! Wall time (in seconds) spent deciding which tiles to refine and
+	//! counting their selected sub-zones
+	double countTime{};
+	//! Wall time (in seconds) spent finding and recording the positions of
+	//! the new zones and tiles
+	double scanTime{};
+	//! Wall time (in seconds) spent creating the new zones and tiles
+	double assignTime{};
+
+	//! Number of (active) tiles considered for refinement
+	IdType tilesExamined{};
+	//! Number of calls to the detector to decide refinement
+	IdType refineCalls{};
+	//! Number of calls to the detector to decide selection
+	IdType selectCalls{};
+
+	//! Number of zones created
+	IdType zonesCreated{};
+	//! Number of tiles created (not counting refined tiles, which are reused)
+	IdType tilesCreated{};
+
+	//! Number of bytes by which the RefinementWorkspace grew
+	std::uint64_t scratchBytesAllocated{};
+	//! Device memory used (by the Subpaving and the RefinementWorkspace) at
+	//! the end of the level
+	std::uint64_t deviceMemorySize{};
+};
+
+/*!
+ * @brief Measurements for a call to Subpaving::refine(), one
+ * RefinementLevelReport per level processed
+ *
+ * @test unittest_Subpaving.cpp
+ */
+struct RefinementReport
+{
+	std::vector<RefinementLevelReport> levels;
+	//! Number of level-balance passes (see Subpaving::setLevelBalance()),
+	//! whose levels follow those of the detector's refinement
+	std::size_t balancePasses{};
+	//! Number of batches of budgeted refinement (see RefinementBudget),
+	//! whose levels come first
+	std::size_t budgetBatches{};
+	//! Whether budgeted refinement stopped at the budget with tiles left
+	//! which the detector would refine
+	bool budgetReached{false};
+	//! Whether the result was loaded from a RefinementCache (in which case
+	//! the levels are those of the refinement which stored it)
+	bool loadedFromCache{false};
+
+	/*!
+	 * @brief Get the total wall time (in seconds) over all levels
+	 */
+	double
+	getTotalTime() const noexcept
+	{
+		double ret{};
+		for (const auto& level : levels) {
+			ret += level.countTime + level.scanTime + level.assignTime;
+		}
+		return ret;
+	}
+
+	/*!
+	 * @brief Get the total number of zones created over all levels
+	 */
+	IdType
+	getZonesCreated() const noexcept
+	{
+		IdType ret{};
+		for (const auto& level : levels) {
+			ret += level.zonesCreated;
+		}
+		return ret;
+	}
+
+	/*!
+	 * @brief Get the total number of tiles created over all levels
+	 */
+	IdType
+	getTilesCreated() const noexcept
+	{
+		IdType ret{};
+		for (const auto& level : levels) {
+			ret += level.tilesCreated;
+		}
+		return ret;
+	}
+
+	/*!
+	 * @brief Get the largest device memory size reached at the end of any
+	 * level
+	 */
+	std::uint64_t
+	getDeviceMemoryHighWater() const noexcept
+	{
+		std::uint64_t ret{};
+		for (const auto& level : levels) {
+			ret = (level.deviceMemorySize > ret) ? level.deviceMemorySize : ret;
+		}
+		return ret;
+	}
+};
+} // namespace plsm
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include <Kokkos_Bitset.hpp>
+#include <Kokkos_Core.hpp>
+
+#include <plsm/Utility.h>
+#include <plsm/refine/Detector.h>
+
+namespace plsm
+{
+namespace detail
+{
+template <typename TSubpaving, typename TDetector>
+class Refiner;
+
+/*!
+ * @brief Bits marking the selected candidate sub-zones of a tile
+ */
+using SelectionMask = std::uint32_t;
+}
+
+/*!
+ * @brief RefinementWorkspace holds the scratch buffers used by
+ * Subpaving::refine()
+ *
+ * The buffers are only ever grown (to the largest size needed so far), so
+ * passing the same workspace to successive calls to refine() avoids
+ * allocating them again for every level of every call.
+ *
+ * @tparam Dim The dimension of the lattice of the Subpaving
+ *
+ * @test unittest_Subpaving.cpp
+ */
+template <DimType Dim>
+class RefinementWorkspace
+{
+	template <typename TSubpaving, typename TDetector>
+	friend class detail::Refiner;
+
+public:
+	//! Type for per-tile (or per-zone) ids and counts
+	using IdsView = Kokkos::View<IdType*>;
+	//! Type for per-tile detector classifications
+	using ClassificationsView = Kokkos::View<refine::Classification*>;
+	//! Type for per-tile flags
+	using Bitset = Kokkos::Bitset<DefaultExecSpace>;
+	//! Type for per-tile selection masks
+	using SelectionMasksView = Kokkos::View<detail::SelectionMask*>;
+
+	RefinementWorkspace() = default;
+
+	/*!
+	 * @brief Get the number of tiles for which a refinement level can be
+	 * processed without growing the buffers
+	 */
+	IdType
+	getCapacity() const noexcept
+	{
+		return static_cast<IdType>(_newZoneCounts.size());
+	}
+
+	/*!
+	 * @brief Get the total size (in bytes) of the buffers
+	 */
+	std::uint64_t
+	getDeviceMemorySize() const noexcept
+	{
+		std::uint64_t ret{};
+		for (auto view : {&_newZoneCounts, &_subZoneStarts, &_newTileStarts,
+				 &_selectedSubZones, &_activeTiles, &_nextActiveTiles}) {
+			ret += view->required_allocation_size(view->size());
+		}
+		for (auto view : {&_classifications, &_nextClassifications}) {
+			ret += view->required_allocation_size(view->size());
+		}
+		ret += _selectionMasks.required_allocation_size(
+			_selectionMasks.size());
+		for (const auto& bitset : _enableRefine) {
+			ret += ((bitset.size() + 31) / 32) * sizeof(unsigned);
+		}
+		return ret;
+	}
+
+	/*!
+	 * @brief Release the buffers
+	 */
+	void
+	clear()
+	{
+		*this = RefinementWorkspace{};
+	}
+
+private:
+	/*!
+	 * @brief Ensure the buffers for a level can hold the given numbers of
+	 * active tiles and new zones
+	 */
+	void
+	reserve(IdType numActiveTiles, IdType numNewZones)
+	{
+		grow(_newZoneCounts, "New Zone Counts", numActiveTiles);
+		grow(_subZoneStarts, "SubZone Start Ids", numActiveTiles);
+		grow(_newTileStarts, "Tile Start Ids", numActiveTiles);
+		grow(_activeTiles, "Active Tiles", numActiveTiles);
+		grow(_classifications, "Classifications", numActiveTiles);
+		grow(_selectionMasks, "Selection Masks", numActiveTiles);
+		for (auto& bitset : _enableRefine) {
+			if (bitset.size() < numActiveTiles) {
+				bitset = Bitset(static_cast<unsigned>(numActiveTiles));
+			}
+		}
+		grow(_selectedSubZones, "Selected Sub-Zones", numNewZones);
+		grow(_nextActiveTiles, "Active Tiles", numNewZones);
+		grow(_nextClassifications, "Classifications", numNewZones);
+	}
+
+	/*!
+	 * @brief Reallocate (without copying) the given view if it is smaller
+	 * than the given size
+	 */
+	template <typename TView>
+	static void
+	grow(TView& view, const char* label, IdType size)
+	{
+		if (view.size() < size) {
+			view = TView(Kokkos::ViewAllocateWithoutInitializing{label}, size);
+		}
+	}
+
+	/*!
+	 * @brief Make the tiles produced at one level the active tiles for the
+	 * next
+	 */
+	void
+	advanceLevel() noexcept
+	{
+		std::swap(_activeTiles, _nextActiveTiles);
+		std::swap(_classifications, _nextClassifications);
+	}
+
+private:
+	IdsView _newZoneCounts;
+	IdsView _subZoneStarts;
+	IdsView _newTileStarts;
+	IdsView _selectedSubZones;
+	IdsView _activeTiles;
+	IdsView _nextActiveTiles;
+	ClassificationsView _classifications;
+	ClassificationsView _nextClassifications;
+	Kokkos::Array<Bitset, Dim> _enableRefine{};
+	SelectionMasksView _selectionMasks;
+};
+} // namespace plsm
@@ -1,15 +1,32 @@
 #pragma once
 
+#include <string>
 #include <type_traits>
 #include <vector>
 
 #include <Kokkos_Core.hpp>
 
 #include <plsm/EnumIndexed.h>
+#include <plsm/MappedFile.h>
+#include <plsm/Prolongation.h>
+#include <plsm/RefinementBudget.h>
+#include <plsm/RefinementCache.h>
+#include <plsm/RefinementReport.h>
+#include <plsm/RefinementWorkspace.h>
+#include <plsm/SumOverlaps.h>
+#include <plsm/Tile.h>
+#include <plsm/TileAdjacency.h>
+#include <plsm/TileAttributes.h>
 #include <plsm/Utility.h>
 #include <plsm/Zone.h>
+#include <plsm/detail/Coarsener.h>
 #include <plsm/detail/Refiner.h>
+#include <plsm/detail/SpaceFillingCurve.h>
 #include <plsm/detail/SubdivisionInfo.h>
+#include <plsm/detail/SubpavingFile.h>
+#include <plsm/detail/ZoneColumns.h>
+#include <plsm/detail/ZoneRegion.h>
+#include <plsm/refine/RegionDetector.h>
 
 namespace plsm
 {
@@ -31,7 +48,9 @@ struct SubpavingTester;
  * @tparam TScalar The underlying type for scalar representation for the lattice
  * @tparam Dim The dimension of the lattice
  * @tparam TEnumIndex An optional enum type to be used to index the space
- * @tparam TItemData An optional data type to associate with each Tile
+ * @tparam TItemData An optional (trivially copyable) data type to associate
+ * with each Tile, stored separately from the tiles (see getItemData() and
+ * getTileData())
  *
  * @test unittest_Subpaving.cpp
  * @test benchmark_Subpaving.cpp
@@ -46,7 +65,12 @@ class Subpaving
 	template <typename TSubpaving, typename TSelector>
 	friend class detail::Refiner;
 
+	template <typename TSubpaving, typename TDetector>
+	friend class detail::Coarsener;
+
 	static_assert(Kokkos::is_memory_space<TMemSpace>{});
+	static_assert(std::is_trivially_copyable_v<TItemData>,
+		"Tile item data must be trivially copyable");
 
 public:
 	//! The memory space for the subpaving data
@@ -64,20 +88,49 @@ public:
 
 	//! The subdivision Zone
 	using ZoneType = Zone<RegionType>;
+#if defined(PLSM_USE_PACKED_ZONES)
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	static_assert(sizeof(ZoneType) <= 4 * sizeof(IdType),
+		"A packed zone should fit in four indices");
+#else
+	static_assert(sizeof(ZoneType) <= sizeof(RegionType) + 4 * sizeof(IdType),
+		"A packed zone should fit in its region and four indices");
+#endif
+#endif
+#if defined(PLSM_USE_SOA_ZONES)
+	//! The type for the set of zones on the given memory space (with each
+	//! field in a separate view)
+	using ZonesView = detail::ZoneColumns<ZoneType, MemorySpace>;
+	//! Read-only random-access view of zones
+	using ZonesRAView = detail::ZoneColumns<ZoneType, MemorySpace, true>;
+#else
 	//! The type for the set of zones on the given memory space
 	using ZonesView = Kokkos::View<ZoneType*, MemorySpace>;
 	//! Read-only random-access view of zones
 	using ZonesRAView =
 		Kokkos::View<const ZoneType*, MemorySpace, Kokkos::MemoryRandomAccess>;
+#endif
 
-	//! The subpaving Tile
-	using TileType = Tile<RegionType, ItemDataType>;
+	//! The subpaving Tile (without data, which is stored separately)
+	using TileType = Tile<RegionType, void>;
 	//! The type for the set of tiles on the given memory space
 	using TilesView = Kokkos::View<TileType*, MemorySpace>;
 	//! Read-only random-access view of tiles
 	using TilesRAView =
 		Kokkos::View<const TileType*, MemorySpace, Kokkos::MemoryRandomAccess>;
 
+	//! The type for the item data of each tile on the given memory space
+	using ItemDataView = Kokkos::View<ItemDataType*, MemorySpace>;
+
+	//! Tiles overlapping the sums of pairs of tiles (see findSumOverlaps())
+	using SumOverlapsType = SumOverlaps<MemorySpace>;
+
+	//! Graph of the tiles sharing faces (see findFaceNeighbors())
+	using TileAdjacencyType = TileAdjacency<MemorySpace>;
+
+	//! Scratch space which can be reused across calls to refine()
+	using RefinementWorkspaceType = RefinementWorkspace<Dim>;
+
 	using HostMirrorSpace = typename TilesView::traits::host_mirror_space;
 	using HostMirror =
 		Subpaving<TScalar, Dim, TEnumIndex, TItemData, HostMirrorSpace>;
@@ -134,6 +187,42 @@ public:
 	HostMirror
 	makeMirrorCopy() const;
 
+	/*!
+	 * @brief Write the Subpaving (root region, subdivision infos, zones,
+	 * tiles, item data, and refinement depth) to the given file in a
+	 * versioned binary format
+	 *
+	 * The data is stored with the native byte order and layout, so it can
+	 * only be loaded by the same Subpaving type on a compatible machine.
+	 */
+	void
+	save(const std::string& path) const;
+
+	/*!
+	 * @brief Replace the Subpaving with one read from the given file (see
+	 * save())
+	 *
+	 * The registered tile attributes (see setTileAttributes()) are reset to
+	 * zeros for the loaded tiles.
+	 */
+	void
+	load(const std::string& path);
+
+	/*!
+	 * @brief Replace the Subpaving with one stored in the given mapped file
+	 * (see save()), using the stored zones, tiles, item data, and
+	 * subdivision infos in place rather than copying them
+	 *
+	 * This is only available for memory spaces accessible from the host.
+	 * The Subpaving refers to the mapped memory (until refinement or
+	 * coarsening replaces its zones and tiles), so the file must stay mapped
+	 * while the Subpaving (or any copy) is in use. With PLSM_USE_SOA_ZONES,
+	 * the zones are copied into separate views for their fields. The
+	 * registered tile attributes are reset as by load(path).
+	 */
+	void
+	load(const MappedFile& file);
+
 	/*!
 	 * @brief Get root region
 	 */
@@ -169,6 +258,150 @@ public:
 		return _tilesRA;
 	}
 
+	/*!
+	 * @brief Get the item data for each tile (indexed like the tiles)
+	 *
+	 * The data is kept in step with the tiles: refinement initializes the
+	 * data of new tiles (see setItemDataInit()), coarsening keeps the data
+	 * of the tile each zone's tiles are merged into, and reorderTiles()
+	 * reorders it.
+	 */
+	KOKKOS_INLINE_FUNCTION
+	const ItemDataView&
+	getItemData() const
+	{
+		return _itemData;
+	}
+
+	//!@{
+	/*!
+	 * @brief Get/Set the item data of the given tile
+	 *
+	 * Tiles used to hold their own data (getTiles()(i).getData() and
+	 * setData()). Code doing that should call getTileData(i) and
+	 * setTileData(i, data) instead, which work in kernels too. Unlike the
+	 * data held in a Tile, arithmetic data starts value-initialized rather
+	 * than invalid.
+	 */
+	KOKKOS_INLINE_FUNCTION
+	ItemDataType&
+	getTileData(IdType tileId) const
+	{
+		return _itemData(tileId);
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	void
+	setTileData(IdType tileId, const ItemDataType& data) const
+	{
+		_itemData(tileId) = data;
+	}
+	//!@}
+
+	/*!
+	 * @brief Get how refinement initializes the item data of new tiles
+	 */
+	ItemDataInit
+	getItemDataInit() const noexcept
+	{
+		return _itemDataInit;
+	}
+
+	/*!
+	 * @brief Set how refinement initializes the item data of new tiles
+	 * (ItemDataInit::copyParent by default)
+	 */
+	void
+	setItemDataInit(ItemDataInit init) noexcept
+	{
+		_itemDataInit = init;
+	}
+
+	//! Value for setLevelBalance() which leaves the levels unconstrained
+	static constexpr std::size_t noLevelBalance = wildcard<std::size_t>;
+
+	/*!
+	 * @brief Get the largest level difference allowed between tiles which
+	 * share a face after refinement
+	 */
+	std::size_t
+	getLevelBalance() const noexcept
+	{
+		return _levelBalance;
+	}
+
+	/*!
+	 * @brief Set the largest level difference allowed between tiles which
+	 * share a face after refinement (noLevelBalance by default; 1 gives the
+	 * usual 2:1 balance)
+	 *
+	 * After refining as the detector asks, refine() refines further tiles in
+	 * passes until no tile has a face neighbor (see visitFaceNeighbors())
+	 * more than maxLevelDifference levels finer. Each pass marks the tiles
+	 * which are too coarse, in parallel, and refines them by one level.
+	 * Coarsening does not enforce the balance, and refinement within a
+	 * RefinementBudget does not allow it.
+	 */
+	void
+	setLevelBalance(std::size_t maxLevelDifference) noexcept
+	{
+		_levelBalance = maxLevelDifference;
+	}
+
+	/*!
+	 * @brief Get the registered tile attributes (or nullptr)
+	 */
+	TileAttributes<MemorySpace>*
+	getTileAttributes() const noexcept
+	{
+		return _tileAttributes;
+	}
+
+	/*!
+	 * @brief Register the given tile attributes (see TileAttributes) to be
+	 * kept in step with the tiles, or unregister them with nullptr
+	 *
+	 * Every refine() prolongates the registered columns to the new tiles
+	 * (including refinement within a budget and results from a cache),
+	 * coarsen() merges them, and reorderTiles() permutes them. Loading
+	 * replaces the tiles, so load() resets the columns to zeros for the
+	 * loaded tiles. The table must outlive its registration, and copies of
+	 * the Subpaving share it.
+	 *
+	 * @throw std::invalid_argument if the attributes are not sized for the
+	 * tiles
+	 */
+	void
+	setTileAttributes(TileAttributes<MemorySpace>* attributes);
+
+	/*!
+	 * @brief Get the Region of the given tile (that of its owning zone)
+	 *
+	 * This is available whether or not tiles store their own Region (see
+	 * PLSM_USE_COMPACT_TILES).
+	 */
+	KOKKOS_INLINE_FUNCTION
+	RegionType
+	getTileRegion(IdType tileId) const
+	{
+		return getZoneRegion(_tilesRA(tileId).getOwningZoneIndex());
+	}
+
+	/*!
+	 * @brief Get the Region of the given zone
+	 *
+	 * This is available whether or not zones store their own Region (see
+	 * PLSM_USE_IMPLICIT_ZONE_REGIONS). If they do not, it is reconstructed
+	 * with a walk up the tree.
+	 */
+	KOKKOS_INLINE_FUNCTION
+	RegionType
+	getZoneRegion(IdType zoneId) const
+	{
+		return detail::getZoneRegion(
+			_zonesRA, _subdivisionInfos, _rootRegion, zoneId);
+	}
+
 	/*!
 	 * @brief Get current number of tiles
 	 */
@@ -199,6 +432,41 @@ public:
 		return _zonesRA;
 	}
 
+	/*!
+	 * @brief Get the number of zones for which space is allocated
+	 */
+	IdType
+	getZoneCapacity() const noexcept
+	{
+		return static_cast<IdType>(_zoneStorage.size());
+	}
+
+	/*!
+	 * @brief Get the number of tiles for which space is allocated
+	 */
+	IdType
+	getTileCapacity() const noexcept
+	{
+		return static_cast<IdType>(_tileStorage.size());
+	}
+
+	/*!
+	 * @brief Allocate space for at least the given numbers of zones and tiles
+	 *
+	 * Refinement grows the capacity geometrically as needed, so this is only
+	 * useful to avoid the intermediate allocations when the final size is
+	 * known (or can be estimated) in advance.
+	 */
+	void
+	reserve(IdType numZones, IdType numTiles);
+
+	/*!
+	 * @brief Release any space allocated beyond the current numbers of zones
+	 * and tiles
+	 */
+	void
+	shrinkToFit();
+
 	/*!
 	 * @brief Get the current refinement depth
 	 */
@@ -210,11 +478,144 @@ public:
 
 	/*!
 	 * @brief Refine the Subpaving according to the given refine::Detector
+	 *
+	 * All overloads return a RefinementReport with measurements (timings,
+	 * detector calls, items created, memory) for each level processed.
 	 */
 	template <typename TRefinementDetector>
-	void
+	RefinementReport
 	refine(TRefinementDetector&& detector);
 
+	/*!
+	 * @brief Refine the Subpaving according to the given refine::Detector,
+	 * and relate the resulting tiles to those from before refinement
+	 *
+	 * @param[out] prolongation Parent tile and volume fraction for each tile
+	 * (see Prolongation::apply() for transferring per-tile data)
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refine(TRefinementDetector&& detector,
+		Prolongation<MemorySpace>& prolongation);
+
+	/*!
+	 * @brief Refine the Subpaving according to the given refine::Detector,
+	 * using (and growing as needed) the scratch buffers of the given
+	 * workspace
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refine(TRefinementDetector&& detector, RefinementWorkspaceType& workspace);
+
+	/*!
+	 * @brief Refine the Subpaving according to the given refine::Detector
+	 * using the given workspace, and relate the resulting tiles to those from
+	 * before refinement
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refine(TRefinementDetector&& detector,
+		Prolongation<MemorySpace>& prolongation,
+		RefinementWorkspaceType& workspace);
+
+	/*!
+	 * @brief Refine the Subpaving according to the given refine::Detector,
+	 * or load the result of the same refinement from the given cache
+	 *
+	 * If the detector provides a hash (see refine::Detector::hash()), the
+	 * result is looked up in the cache by that hash and a hash of the
+	 * current state of the Subpaving (including the item data, see
+	 * ItemDataHash). If it is not found, the Subpaving is refined and the
+	 * result is stored in the cache. A result loaded from the cache comes
+	 * with the report of the refinement which stored it.
+	 *
+	 * @throw std::invalid_argument if the detector provides a hash but the
+	 * item data type has no ItemDataHash
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refine(TRefinementDetector&& detector, const RefinementCache& cache);
+
+	/*!
+	 * @brief Refine the Subpaving according to the given refine::Detector, or
+	 * load the result from the given cache, and relate the resulting tiles
+	 * to those from before refinement
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refine(TRefinementDetector&& detector, const RefinementCache& cache,
+		Prolongation<MemorySpace>& prolongation);
+
+	/*!
+	 * @brief Refine the Subpaving according to the given refine::Detector
+	 * using the given workspace, or load the result from the given cache
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refine(TRefinementDetector&& detector, const RefinementCache& cache,
+		RefinementWorkspaceType& workspace);
+
+	/*!
+	 * @brief Refine the Subpaving according to the given refine::Detector,
+	 * best-first within the given budget
+	 *
+	 * Each batch refines by one level the (up to budget.batchSize) tiles
+	 * which the detector would refine with the highest priorities (see
+	 * refine::Detector::priority()), in parallel. A batch is cut short
+	 * where the next tile could take the number of tiles or the device
+	 * memory over the budget, counting every candidate sub-zone as
+	 * selected. With a memory limit, the storage is grown to what each batch
+	 * needs rather than geometrically, so that it stays within the budget;
+	 * the scratch space used along the way is not counted.
+	 *
+	 * @throw std::invalid_argument if budget.batchSize is 0, or if a level
+	 * balance is set (see setLevelBalance()), which could not be enforced
+	 * within the budget
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refine(TRefinementDetector&& detector, const RefinementBudget& budget);
+
+	/*!
+	 * @brief Refine the Subpaving according to the given refine::Detector,
+	 * best-first within the given budget, and relate the resulting tiles to
+	 * those from before refinement
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refine(TRefinementDetector&& detector, const RefinementBudget& budget,
+		Prolongation<MemorySpace>& prolongation);
+
+	/*!
+	 * @brief Coarsen the Subpaving according to the given refine::Detector
+	 *
+	 * Wherever the detector would no longer refine a zone whose sub-zones are
+	 * all tiles, those tiles are merged into a single tile for the zone. This
+	 * is repeated up the tree, and then the remaining zones and tiles are
+	 * compacted (keeping their relative order).
+	 *
+	 * @return Map from old to new tile ids, in which each merged tile maps to
+	 * the tile it was merged into
+	 */
+	template <typename TCoarseningDetector>
+	Kokkos::View<IdType*, MemorySpace>
+	coarsen(TCoarseningDetector&& detector);
+
+	/*!
+	 * @brief Reorder the tiles along the given space-filling curve (by the
+	 * origins of their regions), so that tiles near each other in space are
+	 * mostly near each other in memory
+	 *
+	 * Refinement appends the tiles produced from a tile at the end, which
+	 * scatters neighboring tiles through memory. The zones are updated to
+	 * refer to the reordered tiles.
+	 *
+	 * @return Order of the tiles, as the previous id of each tile; per-tile
+	 * data is reordered to match by newData(i) = oldData(order(i))
+	 */
+	Kokkos::View<IdType*, MemorySpace>
+	reorderTiles(SpaceFillingCurve curve = SpaceFillingCurve::morton);
+
 	/*!
 	 * @brief Perform a tree search (using the zones) for the given point, and
 	 * return the id of the containing tile (or invalid if not found)
@@ -223,12 +624,156 @@ public:
 	IdType
 	findTileId(const PointType& point) const;
 
+	/*!
+	 * @brief Find the containing tile for each of the given points (see
+	 * findTileId())
+	 *
+	 * @param points Points to locate
+	 * @param[out] tileIds Id of the tile containing each point (or invalid if
+	 * not found); reallocated if its size does not match points
+	 * @param sortPoints Whether to search the points in Morton order, so that
+	 * nearby points (which follow mostly the same path through the zones) are
+	 * searched together. The results are stored in the order of the given
+	 * points either way.
+	 *
+	 * @return Number of points not found
+	 */
+	IdType
+	findTileIds(const Kokkos::View<PointType*, MemorySpace>& points,
+		Kokkos::View<IdType*, MemorySpace>& tileIds,
+		bool sortPoints = true) const;
+
+	/*!
+	 * @brief Call visitor with the id and region of each tile whose region
+	 * intersects the given region, walking the zones depth-first
+	 *
+	 * Only sub-zones intersecting the region are entered. The walk goes back
+	 * up through parent indices rather than keeping its path, so it needs no
+	 * stack and can run within a kernel (one query per thread).
+	 */
+	template <typename TVisitor>
+	KOKKOS_INLINE_FUNCTION
+	void
+	visitTilesIntersecting(const RegionType& region, TVisitor&& visitor) const;
+
+	/*!
+	 * @brief Count the tiles whose regions intersect the given region (see
+	 * visitTilesIntersecting())
+	 */
+	KOKKOS_INLINE_FUNCTION
+	IdType
+	countTilesIntersecting(const RegionType& region) const;
+
+	/*!
+	 * @brief Count the tiles whose regions intersect the given region
+	 *
+	 * The zones are searched one level at a time, in parallel over the zones
+	 * at each level intersecting the region.
+	 */
+	IdType
+	findTilesIntersecting(const RegionType& region) const;
+
+	/*!
+	 * @brief Find the tiles whose regions intersect the given region (see
+	 * findTilesIntersecting(const RegionType&))
+	 *
+	 * @param[out] tileIds Ids of the tiles found, by depth in the zone tree;
+	 * reallocated if its size does not match the number found
+	 *
+	 * @return Number of tiles found
+	 */
+	IdType
+	findTilesIntersecting(const RegionType& region,
+		Kokkos::View<IdType*, MemorySpace>& tileIds) const;
+
+	/*!
+	 * @brief Find the tiles whose regions intersect each of the given regions,
+	 * in parallel over the regions (see visitTilesIntersecting())
+	 *
+	 * The results are in compressed sparse row form: the tiles found for
+	 * region i are tileIds(offsets(i)) up to tileIds(offsets(i + 1)).
+	 *
+	 * @param[out] offsets Start of the tiles found for each region (with one
+	 * more entry for the end); reallocated if its size does not match
+	 * @param[out] tileIds Ids of the tiles found; reallocated if its size does
+	 * not match the total number found
+	 *
+	 * @return Total number of tiles found
+	 */
+	IdType
+	findTilesIntersecting(const Kokkos::View<RegionType*, MemorySpace>& regions,
+		Kokkos::View<IdType*, MemorySpace>& offsets,
+		Kokkos::View<IdType*, MemorySpace>& tileIds) const;
+
+	/*!
+	 * @brief For each of the given pairs of tiles (A, B), find the tiles C
+	 * which overlap the sum of their regions, A + B (see getSumRegion())
+	 *
+	 * Each pair is searched in parallel with visitTilesIntersecting(), once
+	 * to count the overlaps (which sizes the result) and once to record them.
+	 *
+	 * @param firstTileIds First tile (A) of each pair
+	 * @param secondTileIds Second tile (B) of each pair
+	 * @param[out] overlaps Overlapping tiles and overlap volumes for each pair
+	 */
+	void
+	findSumOverlaps(const Kokkos::View<IdType*, MemorySpace>& firstTileIds,
+		const Kokkos::View<IdType*, MemorySpace>& secondTileIds,
+		SumOverlapsType& overlaps) const;
+
+	/*!
+	 * @brief Find the tiles which overlap the sum of the regions of each
+	 * pair of tiles accepted by the given predicate (see
+	 * findSumOverlaps(firstTileIds, secondTileIds, overlaps))
+	 *
+	 * Since the sum is symmetric, each unordered pair is offered once:
+	 * predicate(a, b) is called (on the device) exactly once for each pair
+	 * of tile ids with a <= b, with all pairs in parallel, and the accepted
+	 * pairs are listed ordered by a and then by b.
+	 *
+	 * @throw std::invalid_argument if there are more pairs than fit in an
+	 * unsigned int
+	 */
+	template <typename TPredicate>
+	void
+	findSumOverlaps(
+		const TPredicate& predicate, SumOverlapsType& overlaps) const;
+
+	/*!
+	 * @brief Call visitor with the id of each tile which shares a face with
+	 * the given tile, and the area of the shared face
+	 *
+	 * The neighbors across each face are the tiles intersecting the layer of
+	 * lattice points just outside it (see visitTilesIntersecting()), so they
+	 * are found at any level. Each layer is searched from the nearest zone
+	 * enclosing it rather than from the root. Tiles which only meet at an
+	 * edge or a corner are not neighbors.
+	 */
+	template <typename TVisitor>
+	KOKKOS_INLINE_FUNCTION
+	void
+	visitFaceNeighbors(IdType tileId, TVisitor&& visitor) const;
+
+	/*!
+	 * @brief Build the graph of the tiles which share a face, with the area
+	 * of each shared face, in parallel over the tiles (see
+	 * visitFaceNeighbors())
+	 *
+	 * A counting pass sizes the graph. The neighbors of each tile are listed
+	 * by axis, lower face first.
+	 *
+	 * @param[out] adjacency Graph of the tiles, in compressed sparse row form
+	 */
+	void
+	findFaceNeighbors(TileAdjacencyType& adjacency) const;
+
 private:
 	void
 	setZones(const ZonesView& zones)
 	{
 		_zones = zones;
 		_zonesRA = _zones;
+		_zoneStorage = _zones;
 	}
 
 	void
@@ -236,8 +781,56 @@ private:
 	{
 		_tiles = tiles;
 		_tilesRA = _tiles;
+		_tileStorage = _tiles;
+	}
+
+	void
+	setItemData(const ItemDataView& itemData)
+	{
+		_itemData = itemData;
+		_itemDataStorage = _itemData;
 	}
 
+	/*!
+	 * @brief Change the number of zones (keeping existing zones), growing
+	 * the capacity geometrically if needed
+	 */
+	void
+	resizeZones(IdType numZones)
+	{
+		resizeWithinStorage(_zones, _zoneStorage, numZones);
+		_zonesRA = _zones;
+	}
+
+	/*!
+	 * @brief Change the number of tiles (keeping existing tiles and their
+	 * item data), growing the capacity geometrically if needed
+	 */
+	void
+	resizeTiles(IdType numTiles)
+	{
+		resizeWithinStorage(_tiles, _tileStorage, numTiles);
+		_tilesRA = _tiles;
+		resizeWithinStorage(_itemData, _itemDataStorage, numTiles);
+	}
+
+	/*!
+	 * @brief Reallocate storage with the given capacity, copying the contents
+	 * of view (the leading part of storage) and pointing view into the new
+	 * storage
+	 */
+	template <typename TView>
+	static void
+	reallocateStorage(TView& view, TView& storage, std::size_t capacity);
+
+	/*!
+	 * @brief Point view to the leading part of storage with the given size,
+	 * first reallocating storage (with geometric growth) if it is too small
+	 */
+	template <typename TView>
+	static void
+	resizeWithinStorage(TView& view, TView& storage, std::size_t size);
+
 	void
 	setRefinementDepth(std::size_t depth)
 	{
@@ -251,17 +844,231 @@ private:
 	void
 	processSubdivisionRatios(const std::vector<SubdivisionRatio<Dim>>&);
 
+	/*!
+	 * @brief Get the number of candidate sub-zones for the given zone if only
+	 * some of them were selected (and 0 otherwise)
+	 */
+	template <typename TZone>
+	static KOKKOS_INLINE_FUNCTION
+	IdType
+	getSubZoneMapSize(const ZonesRAView& zones,
+		const Kokkos::View<detail::SubdivisionInfo<Dim>*, MemorySpace>& infos,
+		const TZone& zone);
+
+	/*!
+	 * @brief Call visitor with the id and region of each tile within the
+	 * given zone whose region intersects the given region (see
+	 * visitTilesIntersecting())
+	 */
+	template <typename TVisitor>
+	KOKKOS_INLINE_FUNCTION
+	void
+	visitTilesIntersectingIn(IdType startZoneId,
+		const RegionType& startZoneRegion, const RegionType& region,
+		TVisitor&& visitor) const;
+
+	/*!
+	 * @brief Call visitor with the id and region of each sub-zone of the given
+	 * zone whose region intersects the given region
+	 */
+	template <typename TVisitor>
+	static KOKKOS_INLINE_FUNCTION
+	void
+	visitSubZonesIntersecting(const ZonesRAView& zones,
+		const Kokkos::View<detail::SubdivisionInfo<Dim>*, MemorySpace>& infos,
+		IdType zoneId, const RegionType& zoneRegion, const RegionType& region,
+		TVisitor&& visitor);
+
+	/*!
+	 * @brief Search the zones one level at a time for the tiles whose regions
+	 * intersect the given region (see findTilesIntersecting())
+	 *
+	 * @param[out] tileIds If not null, receives the ids of the tiles found
+	 * @return Number of tiles found
+	 */
+	IdType
+	searchTilesIntersecting(const RegionType& region,
+		Kokkos::View<IdType*, MemorySpace>* tileIds) const;
+
+	/*!
+	 * @brief Check that the registered tile attributes (if any) are sized
+	 * for the tiles
+	 *
+	 * @throw std::invalid_argument if they are not
+	 */
+	void
+	checkTileAttributes() const;
+
+	/*!
+	 * @brief Compute a hash (stable across runs) of the type and current
+	 * state of the Subpaving, reducing over the zones and tiles in place
+	 */
+	std::uint64_t
+	hashState() const;
+
+	/*!
+	 * @brief Mix the bounds of the given Region into the given hash
+	 */
+	static KOKKOS_INLINE_FUNCTION
+	std::uint64_t
+	hashRegion(std::uint64_t hash, const RegionType& region);
+
+	/*!
+	 * @brief Load the contents from the given file (see load()), leaving the
+	 * tile attributes as they are
+	 */
+	void
+	loadFile(const std::string& path);
+
+	/*!
+	 * @brief Make the header describing the stored types (with counts and
+	 * offsets for the current contents)
+	 */
+	detail::SubpavingFileHeader
+	makeFileHeader() const;
+
+	/*!
+	 * @brief Compute the order of a set of points along the given
+	 * space-filling curve through the lattice
+	 *
+	 * @param getPoint Function giving the point for each index
+	 * @return Index of each point, in curve order
+	 */
+	template <typename TGetPoint>
+	Kokkos::View<IdType*, MemorySpace>
+	getCurveOrder(IdType numPoints, const TGetPoint& getPoint,
+		SpaceFillingCurve curve) const;
+
+	/*!
+	 * @brief Compute the order of the given keys (from smallest to largest),
+	 * whose range is known
+	 *
+	 * @return Index of each key, in sorted order
+	 */
+	template <typename TKeys, typename TKeyRange>
+	static Kokkos::View<IdType*, MemorySpace>
+	getSortedOrder(const TKeys& keys, const TKeyRange& keyRange);
+
+	/*!
+	 * @brief Refine using the given workspace (best-first if a budget is
+	 * given, or loading the result if the cache has it), and fill the
+	 * prolongation if one is given
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refineImpl(TRefinementDetector&& detector,
+		RefinementWorkspaceType& workspace,
+		Prolongation<MemorySpace>* prolongation,
+		const RefinementBudget* budget = nullptr,
+		const RefinementCache* cache = nullptr);
+
+	/*!
+	 * @brief Refine in batches of the tiles with the highest priorities until
+	 * nothing is left to refine or the budget is reached (see
+	 * refine(detector, budget))
+	 */
+	template <typename TRefinementDetector>
+	RefinementReport
+	refineBestFirst(const TRefinementDetector& detector,
+		const RefinementBudget& budget, RefinementWorkspaceType& workspace);
+
+	/*!
+	 * @brief Evaluate the given tiles (skipping invalid ids) as candidates
+	 * for refineBestFirst(), and append those which the detector would
+	 * refine to the candidates
+	 *
+	 * @param[in,out] priorities Priority of each tile which the detector
+	 * would refine, grown to the number of tiles
+	 * @param[in,out] numSubZones Number of candidate sub-zones (along the
+	 * axes the detector enables) of each tile which the detector would
+	 * refine, or 0 for the others, grown to the number of tiles
+	 */
+	template <typename TRefinementDetector>
+	void
+	addBudgetCandidates(const TRefinementDetector& detector,
+		const Kokkos::View<IdType*, MemorySpace>& tileIds,
+		Kokkos::View<double*, MemorySpace>& priorities,
+		Kokkos::View<IdType*, MemorySpace>& numSubZones,
+		Kokkos::View<IdType*, MemorySpace>& candidates) const;
+
+	/*!
+	 * @brief Order the candidates of refineBestFirst() by decreasing
+	 * priority, and then by increasing id
+	 */
+	Kokkos::View<IdType*, MemorySpace>
+	sortBudgetCandidates(const Kokkos::View<IdType*, MemorySpace>& candidates,
+		const Kokkos::View<double*, MemorySpace>& priorities) const;
+
+	/*!
+	 * @brief Relate each tile to the tile it was refined from, given the
+	 * number of zones from before refinement
+	 */
+	Prolongation<MemorySpace>
+	makeProlongation(IdType numOldZones) const;
+
+	/*!
+	 * @brief Refine the tiles which are too coarse for the level balance
+	 * (see setLevelBalance()), one pass at a time, until none are left
+	 *
+	 * @param[in,out] report Receives the levels of each pass
+	 */
+	void
+	balanceLevels(
+		RefinementWorkspaceType& workspace, RefinementReport& report);
+
+	/*!
+	 * @brief Find the tiles which have a face neighbor more than the allowed
+	 * number of levels finer
+	 *
+	 * @return Ids of the tiles found (in increasing order)
+	 */
+	Kokkos::View<IdType*, MemorySpace>
+	findUnbalancedTiles() const;
+
+	/*!
+	 * @brief Compute the volume of each tile
+	 */
+	Kokkos::View<double*, MemorySpace>
+	getTileVolumes() const;
+
+	/*!
+	 * @brief Rebuild the mapping from candidate sub-zone to selected sub-zone
+	 * for each partially selected zone
+	 */
+	void
+	updateSubZoneMap();
+
 private:
 	//! Zones represent the entire subdivision tree for the root region
 	ZonesView _zones;
 	ZonesRAView _zonesRA;
+	//! Allocation (of at least the size of _zones) holding the zones
+	ZonesView _zoneStorage;
 	//! Tiles represent the (selected) leaf nodes of the tree
 	TilesView _tiles;
 	TilesRAView _tilesRA;
+	//! Allocation (of at least the size of _tiles) holding the tiles
+	TilesView _tileStorage;
+	//! User data for each tile (kept apart so the tiles stay compact)
+	ItemDataView _itemData;
+	//! Allocation (of the same size as _tileStorage) holding the item data
+	ItemDataView _itemDataStorage;
+	//! How refinement initializes the item data of new tiles
+	ItemDataInit _itemDataInit{ItemDataInit::copyParent};
+	//! Largest level difference allowed between tiles sharing a face
+	std::size_t _levelBalance{noLevelBalance};
+	//! Tile attributes kept in step with the tiles (see setTileAttributes())
+	TileAttributes<MemorySpace>* _tileAttributes{};
 	//! Region which fully encloses the domain of interest
 	RegionType _rootRegion;
 	//! Collection of SubdivisionInfo, one per expected refinement level
 	Kokkos::View<detail::SubdivisionInfo<Dim>*, MemorySpace> _subdivisionInfos;
+	//! For each partially selected zone, the beginning of its entries in
+	//! _subZoneMap
+	Kokkos::View<IdType*, MemorySpace> _subZoneMapStarts;
+	//! For each candidate sub-zone of a partially selected zone, its position
+	//! among the zone's sub-zones (or invalid if it was not selected)
+	Kokkos::View<IdType*, MemorySpace> _subZoneMap;
 	//! Level limit
 	std::size_t _refinementDepth{};
 };
@@ -3,11 +3,17 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <numeric>
 #include <stdexcept>
+#include <string>
 #include <utility>
 
+#include <Kokkos_Bitset.hpp>
+#include <Kokkos_Sort.hpp>
+
 #include <plsm/IntervalRange.h>
 #include <plsm/detail/Refiner.h>
 
@@ -20,14 +26,21 @@ Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::Subpaving(
 	const std::vector<SubdivisionRatio<Dim>>& subdivisionRatios) :
 	_zones("zones", 1),
 	_zonesRA(_zones),
+	_zoneStorage(_zones),
 	_tiles("tiles", 1),
 	_tilesRA(_tiles),
+	_tileStorage(_tiles),
+	_itemData("item data", 1),
+	_itemDataStorage(_itemData),
 	_rootRegion(region)
 {
 	processSubdivisionRatios(subdivisionRatios);
 
 	auto zonesMirror = create_mirror_view(_zones);
-	zonesMirror[0] = ZoneType{_rootRegion, 0};
+	zonesMirror(0) = detail::makeZone<ZoneType>(_rootRegion, 0, 0);
+	// The root zone owns the initial tile, which tree searches and
+	// prolongation (see makeProlongation()) find through it
+	zonesMirror(0).setTileIndex(0);
 	deep_copy(_zones, zonesMirror);
 
 	auto tilesMirror = create_mirror_view(_tiles);
@@ -142,6 +155,28 @@ Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::processSubdivisionRatios(
 		}
 	}
 
+	// Check the limits of the zone encoding (see Zone)
+	if (subdivisionRatios.size() > ZoneType::maxLevel) {
+		throw std::invalid_argument(
+			"Subpaving: number of subdivision levels (" +
+			std::to_string(subdivisionRatios.size()) +
+			") exceeds the maximum zone level (" +
+			std::to_string(ZoneType::maxLevel) + ")");
+	}
+	for (const auto& ratio : subdivisionRatios) {
+		std::size_t numSubZones = 1;
+		for (auto i : makeIntervalRange(Dim)) {
+			numSubZones *= ratio[i];
+		}
+		if (numSubZones > ZoneType::maxNumSubZones) {
+			throw std::invalid_argument(
+				"Subpaving: subdivision ratio product (" +
+				std::to_string(numSubZones) +
+				") exceeds the maximum number of sub-zones per zone (" +
+				std::to_string(ZoneType::maxNumSubZones) + ")");
+		}
+	}
+
 	_subdivisionInfos =
 		Kokkos::View<detail::SubdivisionInfo<Dim>*, MemorySpace>{
 			"Subdivision Infos", subdivisionRatios.size()};
@@ -165,16 +200,295 @@ Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::makeMirrorCopy() const
 	deep_copy(tiles, _tiles);
 	ret.setTiles(tiles);
 
+	auto itemData = create_mirror_view(_itemData);
+	deep_copy(itemData, _itemData);
+	ret.setItemData(itemData);
+	ret._itemDataInit = _itemDataInit;
+	ret._levelBalance = _levelBalance;
+
 	ret._rootRegion = _rootRegion;
 
 	resize(ret._subdivisionInfos, _subdivisionInfos.size());
 	deep_copy(ret._subdivisionInfos, _subdivisionInfos);
 
+	resize(ret._subZoneMapStarts, _subZoneMapStarts.size());
+	deep_copy(ret._subZoneMapStarts, _subZoneMapStarts);
+	resize(ret._subZoneMap, _subZoneMap.size());
+	deep_copy(ret._subZoneMap, _subZoneMap);
+
 	ret._refinementDepth = _refinementDepth;
 
 	return ret;
 }
 
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+std::uint64_t
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::hashState() const
+{
+	using detail::hashCombine;
+
+	// The file layout covers the types (and the format of cached results)
+	auto header = makeFileHeader();
+	auto ret = hashCombine(detail::hashSeed, header.version);
+	ret = hashCombine(ret, header.dimension);
+	ret = hashCombine(ret, header.scalarSize);
+	ret = hashCombine(ret, header.zoneSize);
+	ret = hashCombine(ret, header.tileSize);
+	ret = hashCombine(ret, header.itemDataSize);
+	ret = hashCombine(ret, header.options);
+	ret = hashCombine(ret, _itemDataInit);
+	ret = hashCombine(ret, _levelBalance);
+	ret = hashRegion(ret, _rootRegion);
+	ret = hashCombine(ret, _refinementDepth);
+	auto infos = create_mirror_view(_subdivisionInfos);
+	deep_copy(infos, _subdivisionInfos);
+	for (std::size_t l = 0; l < infos.size(); ++l) {
+		const auto& ratio = infos(l).getRatio();
+		for (auto i : makeIntervalRange(Dim)) {
+			ret = hashCombine(ret, ratio[i]);
+		}
+	}
+
+	// Each zone and tile is hashed with its index on the device, and the
+	// hashes are added up, so the result does not depend on the order of the
+	// reduction
+	auto numZones = static_cast<IdType>(_zones.size());
+	auto subpaving = *this;
+	auto zones = _zonesRA;
+	std::uint64_t zonesHash = 0;
+	Kokkos::parallel_reduce(
+		"HashZones", numZones,
+		KOKKOS_LAMBDA(IdType i, std::uint64_t & running) {
+			const auto& zone = zones(i);
+			auto hash = hashCombine(detail::hashSeed, i);
+			hash = hashRegion(hash, subpaving.getZoneRegion(i));
+			hash = hashCombine(hash, zone.getLevel());
+			hash = hashCombine(hash, zone.getParentIndex());
+			hash = hashCombine(hash, zone.getSubZoneIndices().begin());
+			hash = hashCombine(hash, zone.getSubZoneIndices().end());
+			hash = hashCombine(hash, zone.getTileIndex());
+			running += hash;
+		},
+		zonesHash);
+
+	// Item data is carried into the result, so it is part of the state (for
+	// types with an ItemDataHash)
+	auto tiles = _tilesRA;
+	auto itemData = _itemData;
+	std::uint64_t tilesHash = 0;
+	Kokkos::parallel_reduce(
+		"HashTiles", getNumberOfTiles(),
+		KOKKOS_LAMBDA(IdType i, std::uint64_t & running) {
+			auto hash = hashCombine(detail::hashSeed, i);
+			hash = hashCombine(hash, tiles(i).getOwningZoneIndex());
+			if constexpr (ItemDataHash<ItemDataType>::defined) {
+				hash = ItemDataHash<ItemDataType>::combine(hash, itemData(i));
+			}
+			running += hash;
+		},
+		tilesHash);
+	Kokkos::fence();
+
+	ret = hashCombine(ret, zonesHash);
+	return hashCombine(ret, tilesHash);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+KOKKOS_INLINE_FUNCTION
+std::uint64_t
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::hashRegion(
+	std::uint64_t hash, const RegionType& region)
+{
+	// Hash member by member, since padding bytes are not stable
+	for (auto i : makeIntervalRange(Dim)) {
+		hash = detail::hashCombine(hash, region[i].begin());
+		hash = detail::hashCombine(hash, region[i].end());
+	}
+	return hash;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+detail::SubpavingFileHeader
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::makeFileHeader() const
+{
+	static_assert(std::is_trivially_copyable_v<RegionType>);
+	static_assert(std::is_trivially_copyable_v<detail::SubdivisionInfo<Dim>>);
+	static_assert(std::is_trivially_copyable_v<ZoneType>);
+	static_assert(std::is_trivially_copyable_v<TileType>);
+	static_assert(std::is_trivially_copyable_v<ItemDataType>);
+
+	detail::SubpavingFileHeader header{};
+	header.dimension = static_cast<std::uint32_t>(Dim);
+	header.scalarSize = sizeof(ScalarType);
+	header.regionSize = sizeof(RegionType);
+	header.subdivisionInfoSize = sizeof(detail::SubdivisionInfo<Dim>);
+	header.zoneSize = sizeof(ZoneType);
+	header.tileSize = sizeof(TileType);
+	header.itemDataSize = sizeof(ItemDataType);
+	header.numSubdivisionInfos = _subdivisionInfos.size();
+	header.numZones = _zones.size();
+	header.numTiles = _tiles.size();
+	header.refinementDepth = _refinementDepth;
+	header.computeOffsets();
+	return header;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::save(
+	const std::string& path) const
+{
+	auto header = makeFileHeader();
+	auto sph = makeMirrorCopy();
+
+	std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+	if (!ofs) {
+		throw std::runtime_error("Subpaving: cannot open " + path);
+	}
+	auto writeAt = [&ofs](std::uint64_t offset, const void* data,
+					   std::uint64_t size) {
+		// Pad up to the (aligned) offset
+		static constexpr char zeros[detail::subpavingFileAlignment]{};
+		auto pos = static_cast<std::uint64_t>(ofs.tellp());
+		ofs.write(zeros, static_cast<std::streamsize>(offset - pos));
+		ofs.write(static_cast<const char*>(data),
+			static_cast<std::streamsize>(size));
+	};
+	writeAt(0, &header, sizeof(header));
+	writeAt(header.rootRegionOffset, &sph._rootRegion, header.regionSize);
+	writeAt(header.subdivisionInfosOffset, sph._subdivisionInfos.data(),
+		header.numSubdivisionInfos * header.subdivisionInfoSize);
+#if defined(PLSM_USE_SOA_ZONES)
+	// Files hold an array of Zone whichever way the zones are stored
+	auto zones = detail::makeZoneArray(sph._zones);
+#else
+	const auto& zones = sph._zones;
+#endif
+	writeAt(header.zonesOffset, zones.data(),
+		header.numZones * header.zoneSize);
+	writeAt(header.tilesOffset, sph._tiles.data(),
+		header.numTiles * header.tileSize);
+	writeAt(header.itemDataOffset, sph._itemData.data(),
+		header.numTiles * header.itemDataSize);
+	if (!ofs) {
+		throw std::runtime_error("Subpaving: cannot write " + path);
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::load(
+	const std::string& path)
+{
+	loadFile(path);
+	if (_tileAttributes != nullptr) {
+		_tileAttributes->reset(getNumberOfTiles());
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::loadFile(
+	const std::string& path)
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+	std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+	if (!ifs) {
+		throw std::runtime_error("Subpaving: cannot open " + path);
+	}
+	auto fileSize = static_cast<std::uint64_t>(ifs.tellg());
+	ifs.seekg(0);
+	detail::SubpavingFileHeader header{};
+	ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!ifs) {
+		throw std::runtime_error("Subpaving: cannot load " + path +
+			": not a subpaving file");
+	}
+	header.validate(makeFileHeader(), path, fileSize);
+
+	auto readAt = [&ifs](std::uint64_t offset, void* data,
+					  std::uint64_t size) {
+		ifs.seekg(static_cast<std::streamoff>(offset));
+		ifs.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+	};
+	auto readView = [&readAt](std::uint64_t offset, auto& view) {
+		auto mirror = create_mirror_view(view);
+		readAt(offset, mirror.data(),
+			mirror.size() * sizeof(typename decltype(mirror)::value_type));
+		deep_copy(view, mirror);
+	};
+
+	readAt(header.rootRegionOffset, &_rootRegion, header.regionSize);
+	_subdivisionInfos = decltype(_subdivisionInfos)(
+		AllocNoInit{"Subdivision Infos"}, header.numSubdivisionInfos);
+	readView(header.subdivisionInfosOffset, _subdivisionInfos);
+	auto zones = Kokkos::View<ZoneType*, MemorySpace>(
+		AllocNoInit{"zones"}, header.numZones);
+	readView(header.zonesOffset, zones);
+	setZones(ZonesView{zones});
+	auto tiles = TilesView(AllocNoInit{"tiles"}, header.numTiles);
+	readView(header.tilesOffset, tiles);
+	setTiles(tiles);
+	auto itemData = ItemDataView(AllocNoInit{"item data"}, header.numTiles);
+	readView(header.itemDataOffset, itemData);
+	setItemData(itemData);
+	if (!ifs) {
+		throw std::runtime_error("Subpaving: cannot read " + path);
+	}
+	_refinementDepth = header.refinementDepth;
+
+	updateSubZoneMap();
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::load(
+	const MappedFile& file)
+{
+	static_assert(
+		Kokkos::SpaceAccessibility<Kokkos::HostSpace, MemorySpace>::accessible,
+		"Mapped files can only be used for host-accessible memory spaces");
+
+	auto base = static_cast<char*>(file.data());
+	detail::SubpavingFileHeader header{};
+	if (file.size() < sizeof(header)) {
+		throw std::runtime_error(
+			"Subpaving: cannot load mapped file: not a subpaving file");
+	}
+	std::memcpy(&header, base, sizeof(header));
+	header.validate(makeFileHeader(), "mapped file", file.size());
+
+	std::memcpy(
+		&_rootRegion, base + header.rootRegionOffset, header.regionSize);
+	_subdivisionInfos = decltype(_subdivisionInfos)(
+		reinterpret_cast<detail::SubdivisionInfo<Dim>*>(
+			base + header.subdivisionInfosOffset),
+		header.numSubdivisionInfos);
+	setZones(ZonesView{Kokkos::View<ZoneType*, MemorySpace>(
+		reinterpret_cast<ZoneType*>(base + header.zonesOffset),
+		header.numZones)});
+	setTiles(TilesView(
+		reinterpret_cast<TileType*>(base + header.tilesOffset),
+		header.numTiles));
+	setItemData(ItemDataView(
+		reinterpret_cast<ItemDataType*>(base + header.itemDataOffset),
+		header.numTiles));
+	_refinementDepth = header.refinementDepth;
+
+	updateSubZoneMap();
+	if (_tileAttributes != nullptr) {
+		_tileAttributes->reset(getNumberOfTiles());
+	}
+}
+
 template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
 	typename TMemSpace>
 std::uint64_t
@@ -183,10 +497,13 @@ Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::getDeviceMemorySize()
 {
 	std::uint64_t ret{};
 
-	ret += _tiles.required_allocation_size(_tiles.size());
-	ret += _zones.required_allocation_size(_zones.size());
+	ret += _tileStorage.required_allocation_size(_tileStorage.size());
+	ret += _itemDataStorage.required_allocation_size(_itemDataStorage.size());
+	ret += _zoneStorage.required_allocation_size(_zoneStorage.size());
 	ret += sizeof(_rootRegion);
 	ret += _subdivisionInfos.required_allocation_size(_subdivisionInfos.size());
+	ret += _subZoneMapStarts.required_allocation_size(_subZoneMapStarts.size());
+	ret += _subZoneMap.required_allocation_size(_subZoneMap.size());
 	ret += sizeof(_refinementDepth);
 
 	return ret;
@@ -194,47 +511,1575 @@ Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::getDeviceMemorySize()
 
 template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
 	typename TMemSpace>
-template <typename TRefinementDetector>
 void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::reserve(
+	IdType numZones, IdType numTiles)
+{
+	if (numZones > _zoneStorage.size()) {
+		reallocateStorage(_zones, _zoneStorage, numZones);
+		_zonesRA = _zones;
+	}
+	if (numTiles > _tileStorage.size()) {
+		reallocateStorage(_tiles, _tileStorage, numTiles);
+		_tilesRA = _tiles;
+		reallocateStorage(_itemData, _itemDataStorage, numTiles);
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::shrinkToFit()
+{
+	if (_zoneStorage.size() != _zones.size()) {
+		reallocateStorage(_zones, _zoneStorage, _zones.size());
+		_zonesRA = _zones;
+	}
+	if (_tileStorage.size() != _tiles.size()) {
+		reallocateStorage(_tiles, _tileStorage, _tiles.size());
+		_tilesRA = _tiles;
+		reallocateStorage(_itemData, _itemDataStorage, _tiles.size());
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TView>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::reallocateStorage(
+	TView& view, TView& storage, std::size_t capacity)
+{
+	auto size = std::min(view.size(), capacity);
+	auto newStorage = TView(
+		Kokkos::ViewAllocateWithoutInitializing{storage.label()}, capacity);
+	// Unqualified, so that detail::ZoneColumns finds its own subview()
+	using Kokkos::subview;
+	auto range = Kokkos::make_pair(std::size_t{0}, size);
+	deep_copy(subview(newStorage, range), subview(view, range));
+	storage = newStorage;
+	view = subview(storage, range);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TView>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::resizeWithinStorage(
+	TView& view, TView& storage, std::size_t size)
+{
+	using Kokkos::subview;
+	if (size > storage.size()) {
+		reallocateStorage(view, storage, std::max(size, 2 * storage.size()));
+	}
+	view = subview(storage, Kokkos::make_pair(std::size_t{0}, size));
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
 Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
 	TRefinementDetector&& detector)
 {
-	using Refiner = detail::Refiner<Subpaving, TRefinementDetector>;
-	auto refiner = Refiner{*this, std::forward<TRefinementDetector>(detector)};
-	refiner();
+	RefinementWorkspaceType workspace;
+	return refineImpl(
+		std::forward<TRefinementDetector>(detector), workspace, nullptr);
 }
 
 template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
 	typename TMemSpace>
-KOKKOS_INLINE_FUNCTION
-IdType
-Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findTileId(
-	const PointType& point) const
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
+	TRefinementDetector&& detector, Prolongation<MemorySpace>& prolongation)
 {
-	IdType zoneId = 0;
-	auto zone = _zonesRA(zoneId);
-	auto tileId = invalid<IdType>;
-	if (!zone.getRegion().contains(point)) {
-		return tileId;
+	RefinementWorkspaceType workspace;
+	return refineImpl(
+		std::forward<TRefinementDetector>(detector), workspace, &prolongation);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
+	TRefinementDetector&& detector, RefinementWorkspaceType& workspace)
+{
+	return refineImpl(
+		std::forward<TRefinementDetector>(detector), workspace, nullptr);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
+	TRefinementDetector&& detector, Prolongation<MemorySpace>& prolongation,
+	RefinementWorkspaceType& workspace)
+{
+	return refineImpl(
+		std::forward<TRefinementDetector>(detector), workspace, &prolongation);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
+	TRefinementDetector&& detector, const RefinementCache& cache)
+{
+	RefinementWorkspaceType workspace;
+	return refineImpl(std::forward<TRefinementDetector>(detector), workspace,
+		nullptr, nullptr, &cache);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
+	TRefinementDetector&& detector, const RefinementCache& cache,
+	Prolongation<MemorySpace>& prolongation)
+{
+	RefinementWorkspaceType workspace;
+	return refineImpl(std::forward<TRefinementDetector>(detector), workspace,
+		&prolongation, nullptr, &cache);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
+	TRefinementDetector&& detector, const RefinementCache& cache,
+	RefinementWorkspaceType& workspace)
+{
+	return refineImpl(std::forward<TRefinementDetector>(detector), workspace,
+		nullptr, nullptr, &cache);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
+	TRefinementDetector&& detector, const RefinementBudget& budget)
+{
+	RefinementWorkspaceType workspace;
+	return refineImpl(std::forward<TRefinementDetector>(detector), workspace,
+		nullptr, &budget);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refine(
+	TRefinementDetector&& detector, const RefinementBudget& budget,
+	Prolongation<MemorySpace>& prolongation)
+{
+	RefinementWorkspaceType workspace;
+	return refineImpl(std::forward<TRefinementDetector>(detector), workspace,
+		&prolongation, &budget);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refineImpl(
+	TRefinementDetector&& detector, RefinementWorkspaceType& workspace,
+	Prolongation<MemorySpace>* prolongation, const RefinementBudget* budget,
+	const RefinementCache* cache)
+{
+	using DetectorType = std::decay_t<TRefinementDetector>;
+	using Refiner = detail::Refiner<Subpaving, DetectorType>;
+	auto numZones = static_cast<IdType>(_zones.size());
+
+	if (budget != nullptr && _levelBalance != noLevelBalance) {
+		throw std::invalid_argument("Subpaving: a refinement budget cannot "
+									"be combined with a level balance");
 	}
-	for (;;) {
-		if (zone.hasTile()) {
-			tileId = zone.getTileIndex();
-			break;
+
+	// The result is looked up by the state it starts from and by everything
+	// which decides the refinement
+	std::uint64_t cacheKey{};
+	auto detectorHash = detector.hash();
+	auto useCache = (cache != nullptr && detectorHash != DetectorType::noHash);
+	if (useCache) {
+		if constexpr (!ItemDataHash<ItemDataType>::defined) {
+			throw std::invalid_argument(
+				"Subpaving: the item data type has no ItemDataHash");
 		}
-		auto newZoneId = zoneId;
-		for (auto subZoneId : zone.getSubZoneRange()) {
-			if (_zonesRA(subZoneId).getRegion().contains(point)) {
-				newZoneId = subZoneId;
-				break;
+		cacheKey = detail::hashCombine(hashState(), detectorHash);
+		if (budget != nullptr) {
+			cacheKey = detail::hashCombine(cacheKey, budget->maxTiles);
+			cacheKey = detail::hashCombine(cacheKey, budget->maxDeviceMemory);
+			cacheKey = detail::hashCombine(cacheKey, budget->batchSize);
+		}
+	}
+
+	checkTileAttributes();
+	RefinementReport report;
+	auto path = useCache ? cache->getPath(cacheKey) : std::filesystem::path{};
+	if (useCache && std::filesystem::exists(path)) {
+		// Refinement is deterministic, so the stored result extends the
+		// current zones just as refining would (and the tile attributes are
+		// prolongated below)
+		loadFile(path.string());
+		report = cache->loadReport(cacheKey);
+	}
+	else {
+		if (budget != nullptr) {
+			report = refineBestFirst(detector, *budget, workspace);
+		}
+		else {
+			auto refiner = Refiner{
+				*this, std::forward<TRefinementDetector>(detector), workspace};
+			report = refiner();
+			if (_zones.size() != numZones) {
+				updateSubZoneMap();
 			}
 		}
-		if (newZoneId == zoneId) {
+		if (_levelBalance != noLevelBalance) {
+			balanceLevels(workspace, report);
+		}
+		if (useCache) {
+			// The report is stored first, so that it is there whenever the
+			// result is
+			cache->saveReport(cacheKey, report);
+			auto tmpPath = RefinementCache::getTemporaryPath(path);
+			save(tmpPath.string());
+			std::filesystem::rename(tmpPath, path);
+		}
+	}
+	if (prolongation != nullptr || _tileAttributes != nullptr) {
+		auto newProlongation = makeProlongation(numZones);
+		if (_tileAttributes != nullptr) {
+			_tileAttributes->prolongate(newProlongation);
+		}
+		if (prolongation != nullptr) {
+			*prolongation = newProlongation;
+		}
+	}
+	return report;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+RefinementReport
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::refineBestFirst(
+	const TRefinementDetector& detector, const RefinementBudget& budget,
+	RefinementWorkspaceType& workspace)
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using Refiner = detail::Refiner<Subpaving, TRefinementDetector>;
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+
+	if (budget.batchSize == 0) {
+		throw std::invalid_argument(
+			"Subpaving: refinement budget batch size must be positive");
+	}
+
+	// Every tile is evaluated once here, and later only the tiles each batch
+	// refines or creates
+	auto numTiles = getNumberOfTiles();
+	auto tileIds = IdsView(AllocNoInit{"Budget Tile Ids"}, numTiles);
+	Kokkos::parallel_for(
+		"InitializeBudgetTileIds", numTiles,
+		KOKKOS_LAMBDA(IdType i) { tileIds(i) = i; });
+	Kokkos::fence();
+	Kokkos::View<double*, MemorySpace> priorities;
+	IdsView numSubZones;
+	IdsView candidates;
+	addBudgetCandidates(detector, tileIds, priorities, numSubZones, candidates);
+
+	// The sub-zone map is only rebuilt after the last batch, so its size is
+	// bounded by counting every candidate sub-zone of each refined tile
+	auto numOldZones = _zones.size();
+	std::uint64_t numMapEntries = _subZoneMap.size();
+	auto getMemorySize = [&]() {
+		return getDeviceMemorySize() -
+			_subZoneMapStarts.required_allocation_size(
+				_subZoneMapStarts.size()) -
+			_subZoneMap.required_allocation_size(_subZoneMap.size()) +
+			(_zones.size() + numMapEntries) * sizeof(IdType);
+	};
+	std::uint64_t tileBytes = sizeof(TileType) + sizeof(ItemDataType);
+	auto memoryLimited = (budget.maxDeviceMemory != wildcard<std::uint64_t>);
+
+	RefinementReport report;
+	while (candidates.size() != 0) {
+		auto numZones = static_cast<IdType>(_zones.size());
+		numTiles = getNumberOfTiles();
+		auto memorySize = getMemorySize();
+		if (numTiles >= budget.maxTiles ||
+			memorySize >= budget.maxDeviceMemory) {
+			report.budgetReached = true;
 			break;
 		}
-		zoneId = newZoneId;
-		zone = _zonesRA(zoneId);
+
+		// Take the longest run of candidates (in order, up to the batch
+		// size) which fits in the budget, counting every candidate sub-zone
+		// as selected
+		auto order = sortBudgetCandidates(candidates, priorities);
+		auto numConsidered = std::min<IdType>(
+			static_cast<IdType>(order.size()), budget.batchSize);
+		auto newZoneTotals =
+			IdsView(AllocNoInit{"Budget New Zones"}, numConsidered);
+		Kokkos::parallel_scan(
+			"ScanBudgetNewZones", numConsidered,
+			KOKKOS_LAMBDA(IdType j, IdType & update, const bool finalPass) {
+				update += numSubZones(order(j));
+				if (finalPass) {
+					newZoneTotals(j) = update;
+				}
+			});
+		std::uint64_t zoneCapacity = getZoneCapacity();
+		std::uint64_t tileCapacity = getTileCapacity();
+		std::uint64_t oldZones = numZones;
+		std::uint64_t oldTiles = numTiles;
+		std::uint64_t tileRoom = budget.maxTiles - numTiles;
+		auto memoryRoom = budget.maxDeviceMemory - memorySize;
+		IdType batchSize = 0;
+		Kokkos::parallel_reduce(
+			"CountBudgetBatch", numConsidered,
+			KOKKOS_LAMBDA(IdType j, IdType & running) {
+				std::uint64_t zones = newZoneTotals(j);
+				std::uint64_t tiles = zones - (j + 1);
+				auto zoneGrowth = (oldZones + zones > zoneCapacity) ?
+					oldZones + zones - zoneCapacity :
+					0;
+				auto tileGrowth = (oldTiles + tiles > tileCapacity) ?
+					oldTiles + tiles - tileCapacity :
+					0;
+				// Each zone also has an entry in the sub-zone map starts,
+				// and each candidate sub-zone may have one in the map
+				auto bytes = zoneGrowth * sizeof(ZoneType) +
+					tileGrowth * tileBytes + 2 * zones * sizeof(IdType);
+				// Both grow with j, so the candidates which fit come first
+				if (tiles <= tileRoom && bytes <= memoryRoom) {
+					++running;
+				}
+			},
+			batchSize);
+		Kokkos::fence();
+		if (batchSize == 0) {
+			report.budgetReached = true;
+			break;
+		}
+		auto newZonesMirror = create_mirror_view(newZoneTotals);
+		deep_copy(newZonesMirror, newZoneTotals);
+		auto newZones = newZonesMirror(batchSize - 1);
+		auto newTiles = newZones - batchSize;
+
+		// Geometric growth by the Refiner could overshoot the memory limit
+		if (memoryLimited) {
+			reserve(numZones + newZones, numTiles + newTiles);
+		}
+
+		// Refine the batch by one level, as the detector would
+		auto batchIds =
+			Kokkos::subview(order, Kokkos::make_pair(IdType{0}, batchSize));
+		auto refiner = Refiner{*this, detector, workspace};
+		auto batchReport = refiner(batchIds);
+		report.levels.insert(report.levels.end(), batchReport.levels.begin(),
+			batchReport.levels.end());
+		++report.budgetBatches;
+		numMapEntries += newZones;
+
+		// The candidates which were not taken remain
+		auto numRemaining = static_cast<IdType>(order.size()) - batchSize;
+		candidates = IdsView(AllocNoInit{"Budget Candidates"}, numRemaining);
+		deep_copy(candidates,
+			Kokkos::subview(
+				order, Kokkos::make_pair(batchSize, batchSize + numRemaining)));
+
+		// A refined tile moves to its first sub-zone, and the others are
+		// appended. The tiles of the batch which were not refined selected no
+		// sub-zones, and are dropped.
+		auto numToEvaluate = batchSize + getNumberOfTiles() - numTiles;
+		tileIds = IdsView(AllocNoInit{"Budget Tile Ids"}, numToEvaluate);
+		auto tiles = _tilesRA;
+		Kokkos::parallel_for(
+			"FindBudgetTilesToEvaluate", numToEvaluate,
+			KOKKOS_LAMBDA(IdType k) {
+				if (k >= batchSize) {
+					tileIds(k) = numTiles + k - batchSize;
+					return;
+				}
+				auto tileId = batchIds(k);
+				tileIds(k) = (tiles(tileId).getOwningZoneIndex() >= numZones) ?
+					tileId :
+					invalid<IdType>;
+			});
+		Kokkos::fence();
+		addBudgetCandidates(
+			detector, tileIds, priorities, numSubZones, candidates);
 	}
-	return tileId;
+	if (_zones.size() != numOldZones) {
+		updateSubZoneMap();
+	}
+
+	// The batches refine by one level at a time, so the depth reached is
+	// that of the finest tile
+	if (report.budgetBatches != 0) {
+		auto zones = _zonesRA;
+		auto tiles = _tilesRA;
+		std::size_t maxLevel = 0;
+		Kokkos::parallel_reduce(
+			"FindBudgetDepth", getNumberOfTiles(),
+			KOKKOS_LAMBDA(IdType i, std::size_t & running) {
+				std::size_t level =
+					zones(tiles(i).getOwningZoneIndex()).getLevel();
+				running = (level > running) ? level : running;
+			},
+			Kokkos::Max<std::size_t>(maxLevel));
+		Kokkos::fence();
+		_refinementDepth = std::max(_refinementDepth, maxLevel);
+	}
+
+	return report;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TRefinementDetector>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::addBudgetCandidates(
+	const TRefinementDetector& detector,
+	const Kokkos::View<IdType*, MemorySpace>& tileIds,
+	Kokkos::View<double*, MemorySpace>& priorities,
+	Kokkos::View<IdType*, MemorySpace>& numSubZones,
+	Kokkos::View<IdType*, MemorySpace>& candidates) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+
+	// The per-tile values only ever grow along with the tiles
+	auto numTiles = getNumberOfTiles();
+	if (priorities.size() < numTiles) {
+		Kokkos::resize(priorities, numTiles);
+		Kokkos::resize(numSubZones, numTiles);
+	}
+
+	auto numIds = static_cast<IdType>(tileIds.size());
+	auto prioritiesOut = priorities;
+	auto numSubZonesOut = numSubZones;
+	auto targetDepth =
+		std::min<std::size_t>(detector.depth(), _subdivisionInfos.size());
+	auto subpaving = *this;
+	auto zones = _zonesRA;
+	auto tiles = _tilesRA;
+	auto infos = _subdivisionInfos;
+	IdType numNew = 0;
+	Kokkos::parallel_reduce(
+		"EvaluateBudgetCandidates", numIds,
+		KOKKOS_LAMBDA(IdType k, IdType & running) {
+			auto tileId = tileIds(k);
+			if (tileId == invalid<IdType>) {
+				return;
+			}
+			numSubZonesOut(tileId) = 0;
+			auto zoneId = tiles(tileId).getOwningZoneIndex();
+			auto level = zones(zoneId).getLevel();
+			if (level >= targetDepth) {
+				return;
+			}
+			auto region = subpaving.getZoneRegion(zoneId);
+			refine::BoolVec<RegionType> enable{};
+			if (!detector(detector.refineTag, region, enable)) {
+				return;
+			}
+			// Only the enabled axes are subdivided (as in the Refiner)
+			const auto& ratio = infos(level).getRatio();
+			IdType count = 1;
+			for (auto i : makeIntervalRange(Dim)) {
+				if (enable[i]) {
+					count *= static_cast<IdType>(ratio[i]);
+				}
+			}
+			prioritiesOut(tileId) = detector.priority(region);
+			numSubZonesOut(tileId) = count;
+			++running;
+		},
+		numNew);
+	Kokkos::fence();
+
+	// Append the new candidates to those remaining
+	auto numOld = static_cast<IdType>(candidates.size());
+	auto newCandidates =
+		IdsView(AllocNoInit{"Budget Candidates"}, numOld + numNew);
+	deep_copy(
+		Kokkos::subview(newCandidates, Kokkos::make_pair(IdType{0}, numOld)),
+		candidates);
+	Kokkos::parallel_scan(
+		"AppendBudgetCandidates", numIds,
+		KOKKOS_LAMBDA(IdType k, IdType & position, const bool finalPass) {
+			auto tileId = tileIds(k);
+			if (tileId != invalid<IdType> && numSubZonesOut(tileId) != 0) {
+				if (finalPass) {
+					newCandidates(numOld + position) = tileId;
+				}
+				++position;
+			}
+		});
+	Kokkos::fence();
+	candidates = newCandidates;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+Kokkos::View<IdType*, TMemSpace>
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::sortBudgetCandidates(
+	const Kokkos::View<IdType*, MemorySpace>& candidates,
+	const Kokkos::View<double*, MemorySpace>& priorities) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+	// Each candidate gets a key of the number of candidates with a higher
+	// priority (found in the sorted priorities) and then its id, so that
+	// sorting the keys orders by decreasing priority and then increasing id
+	auto numCandidates = static_cast<IdType>(candidates.size());
+	auto sortedPriorities = Kokkos::View<double*, MemorySpace>(
+		AllocNoInit{"Budget Sorted Priorities"}, numCandidates);
+	Kokkos::parallel_for(
+		"GatherBudgetPriorities", numCandidates, KOKKOS_LAMBDA(IdType j) {
+			sortedPriorities(j) = priorities(candidates(j));
+		});
+	Kokkos::fence();
+	Kokkos::sort(sortedPriorities);
+
+	std::uint64_t idBound = getNumberOfTiles();
+	auto keys = Kokkos::View<std::uint64_t*, MemorySpace>(
+		AllocNoInit{"Budget Keys"}, numCandidates);
+	Kokkos::parallel_for(
+		"MakeBudgetKeys", numCandidates, KOKKOS_LAMBDA(IdType j) {
+			auto priority = priorities(candidates(j));
+			IdType begin = 0;
+			IdType end = numCandidates;
+			while (begin < end) {
+				auto mid = begin + (end - begin) / 2;
+				if (sortedPriorities(mid) <= priority) {
+					begin = mid + 1;
+				}
+				else {
+					end = mid;
+				}
+			}
+			std::uint64_t numHigher = numCandidates - begin;
+			keys(j) = numHigher * idBound + candidates(j);
+		});
+	Kokkos::fence();
+	Kokkos::sort(keys);
+
+	auto order = Kokkos::View<IdType*, MemorySpace>(
+		AllocNoInit{"Budget Order"}, numCandidates);
+	Kokkos::parallel_for(
+		"DecodeBudgetKeys", numCandidates, KOKKOS_LAMBDA(IdType j) {
+			order(j) = static_cast<IdType>(keys(j) % idBound);
+		});
+	Kokkos::fence();
+	return order;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+Prolongation<TMemSpace>
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::makeProlongation(
+	IdType numOldZones) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using ProlongationType = Prolongation<MemorySpace>;
+
+	auto numTiles = getNumberOfTiles();
+	auto zones = _zonesRA;
+	auto tiles = _tilesRA;
+	auto subpaving = *this;
+	auto parentTileIds = typename ProlongationType::IdsView(
+		AllocNoInit{"Parent Tile Ids"}, numTiles);
+	auto weights = typename ProlongationType::WeightsView(
+		AllocNoInit{"Prolongation Weights"}, numTiles);
+	Kokkos::parallel_for(
+		"MakeProlongation", numTiles, KOKKOS_LAMBDA(IdType i) {
+			// Find the zone which was a tile before refinement
+			auto zoneId = tiles(i).getOwningZoneIndex();
+			while (zoneId >= numOldZones) {
+				zoneId = zones(zoneId).getParentIndex();
+			}
+			weights(i) = subpaving.getTileRegion(i).volume() /
+				subpaving.getZoneRegion(zoneId).volume();
+
+			// Refining a tile passes its id down to the first sub-zone
+			while (!zones(zoneId).hasTile()) {
+				zoneId = zones(zoneId).getSubZoneIndices().begin();
+			}
+			parentTileIds(i) = zones(zoneId).getTileIndex();
+		});
+	Kokkos::fence();
+
+	return ProlongationType{parentTileIds, weights};
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::balanceLevels(
+	RefinementWorkspaceType& workspace, RefinementReport& report)
+{
+	// Every tile given to the Refiner is within the root region, so each one
+	// is refined into all of its sub-zones
+	using DetectorType = refine::RegionDetector<ScalarType, Dim,
+		refine::TagPair<refine::Overlap, refine::SelectAll>>;
+	using Refiner = detail::Refiner<Subpaving, DetectorType>;
+
+	// Each pass refines only the tiles found by one level, which never goes
+	// deeper than their finer neighbors, so the refinement depth stands
+	for (auto tileIds = findUnbalancedTiles(); tileIds.size() != 0;
+		 tileIds = findUnbalancedTiles()) {
+		auto refiner = Refiner{*this, DetectorType{_rootRegion}, workspace};
+		auto passReport = refiner(tileIds);
+		report.levels.insert(report.levels.end(), passReport.levels.begin(),
+			passReport.levels.end());
+		++report.balancePasses;
+		updateSubZoneMap();
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+Kokkos::View<IdType*, TMemSpace>
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findUnbalancedTiles()
+	const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+	auto numTiles = getNumberOfTiles();
+	auto marks = Kokkos::View<bool*, MemorySpace>(
+		AllocNoInit{"Balance Marks"}, numTiles);
+	auto subpaving = *this;
+	auto zones = _zonesRA;
+	auto tiles = _tilesRA;
+	auto maxDifference = _levelBalance;
+	IdType numMarked = 0;
+	Kokkos::parallel_reduce(
+		"MarkUnbalancedTiles", numTiles,
+		KOKKOS_LAMBDA(IdType i, IdType & running) {
+			auto getLevel = [&](IdType tileId) -> std::size_t {
+				return zones(tiles(tileId).getOwningZoneIndex()).getLevel();
+			};
+			auto maxLevel = getLevel(i) + maxDifference;
+			bool mark = false;
+			subpaving.visitFaceNeighbors(i, [&](IdType neighborId, double) {
+				if (getLevel(neighborId) > maxLevel) {
+					mark = true;
+				}
+			});
+			marks(i) = mark;
+			if (mark) {
+				++running;
+			}
+		},
+		numMarked);
+	Kokkos::fence();
+
+	auto tileIds = Kokkos::View<IdType*, MemorySpace>(
+		AllocNoInit{"Unbalanced Tile Ids"}, numMarked);
+	if (numMarked != 0) {
+		Kokkos::parallel_scan(
+			"CompactUnbalancedTiles", numTiles,
+			KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+				if (marks(i)) {
+					if (finalPass) {
+						tileIds(update) = i;
+					}
+					++update;
+				}
+			});
+		Kokkos::fence();
+	}
+	return tileIds;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TCoarseningDetector>
+Kokkos::View<IdType*, TMemSpace>
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::coarsen(
+	TCoarseningDetector&& detector)
+{
+	using Coarsener =
+		detail::Coarsener<Subpaving, std::decay_t<TCoarseningDetector>>;
+	checkTileAttributes();
+	Kokkos::View<double*, MemorySpace> oldVolumes;
+	if (_tileAttributes != nullptr) {
+		oldVolumes = getTileVolumes();
+	}
+	auto numZones = _zones.size();
+	auto coarsener =
+		Coarsener{*this, std::forward<TCoarseningDetector>(detector)};
+	auto tileMap = coarsener();
+	if (_zones.size() != numZones) {
+		updateSubZoneMap();
+	}
+	if (_tileAttributes != nullptr) {
+		_tileAttributes->merge(tileMap, oldVolumes, getTileVolumes());
+	}
+	return tileMap;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+Kokkos::View<double*, TMemSpace>
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::getTileVolumes() const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+	auto numTiles = getNumberOfTiles();
+	auto subpaving = *this;
+	auto volumes = Kokkos::View<double*, MemorySpace>(
+		AllocNoInit{"Tile Volumes"}, numTiles);
+	Kokkos::parallel_for(
+		"ComputeTileVolumes", numTiles, KOKKOS_LAMBDA(IdType i) {
+			volumes(i) =
+				static_cast<double>(subpaving.getTileRegion(i).volume());
+		});
+	Kokkos::fence();
+
+	return volumes;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TZone>
+KOKKOS_INLINE_FUNCTION
+IdType
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::getSubZoneMapSize(
+	const ZonesRAView& zones,
+	const Kokkos::View<detail::SubdivisionInfo<Dim>*, MemorySpace>& infos,
+	const TZone& zone)
+{
+	const auto& subZoneIds = zone.getSubZoneIndices();
+	if (subZoneIds.empty()) {
+		return 0;
+	}
+	auto info = detail::getSubZoneInfo(zones, zone, infos(zone.getLevel()));
+	auto numCandidates = info.getRatio().getProduct();
+	return (subZoneIds.length() < numCandidates) ? numCandidates : 0;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::updateSubZoneMap()
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+	auto numZones = static_cast<IdType>(_zones.size());
+	auto zones = _zonesRA;
+	auto infos = _subdivisionInfos;
+	auto mapStarts = Kokkos::View<IdType*, MemorySpace>(
+		AllocNoInit{"Sub-Zone Map Starts"}, numZones);
+	IdType mapSize = 0;
+	Kokkos::parallel_scan(
+		"ScanSubZoneMapStarts", numZones,
+		KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+			if (finalPass) {
+				mapStarts(i) = update;
+			}
+			update += getSubZoneMapSize(zones, infos, zones(i));
+		},
+		mapSize);
+	Kokkos::fence();
+
+	auto map = Kokkos::View<IdType*, MemorySpace>(
+		AllocNoInit{"Sub-Zone Map"}, mapSize);
+	Kokkos::parallel_for(
+		"FillSubZoneMap", numZones, KOKKOS_LAMBDA(IdType i) {
+			const auto& zone = zones(i);
+			auto numCandidates = getSubZoneMapSize(zones, infos, zone);
+			if (numCandidates == 0) {
+				return;
+			}
+			auto mapBegin = mapStarts(i);
+			for (IdType k = 0; k < numCandidates; ++k) {
+				map(mapBegin + k) = invalid<IdType>;
+			}
+			auto subZoneBegin = zone.getSubZoneIndices().begin();
+			const auto& ratio = infos(zone.getLevel()).getRatio();
+			for (auto j : zone.getSubZoneRange()) {
+				auto localId =
+					detail::getLocalIndex(zones, zone, zones(j), ratio);
+				map(mapBegin + localId) = j - subZoneBegin;
+			}
+		});
+	Kokkos::fence();
+
+	_subZoneMapStarts = mapStarts;
+	_subZoneMap = map;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+KOKKOS_INLINE_FUNCTION
+IdType
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findTileId(
+	const PointType& point) const
+{
+	auto tileId = invalid<IdType>;
+	auto region = _rootRegion;
+	if (!region.contains(point)) {
+		return tileId;
+	}
+	IdType zoneId = 0;
+	auto zone = _zonesRA(zoneId);
+	for (;;) {
+		if (zone.hasTile()) {
+			tileId = zone.getTileIndex();
+			break;
+		}
+		const auto& subZoneIds = zone.getSubZoneIndices();
+		if (subZoneIds.empty()) {
+			break;
+		}
+		// The candidate sub-zones form a grid, so the one containing the point
+		// is found directly rather than by testing each of them. If zone
+		// regions are implicit, the region is carried down the path.
+		IdType numCandidates = 0;
+		auto localId = detail::findSubZone(_zonesRA, zone,
+			_subdivisionInfos(zone.getLevel()).getRatio(), region, point,
+			numCandidates);
+		if (subZoneIds.length() < numCandidates) {
+			localId = _subZoneMap(_subZoneMapStarts(zoneId) + localId);
+			if (localId == invalid<IdType>) {
+				break;
+			}
+		}
+		zoneId = subZoneIds.begin() + localId;
+		zone = _zonesRA(zoneId);
+	}
+	return tileId;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+IdType
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findTileIds(
+	const Kokkos::View<PointType*, MemorySpace>& points,
+	Kokkos::View<IdType*, MemorySpace>& tileIds, bool sortPoints) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+	auto numPoints = static_cast<IdType>(points.size());
+	if (tileIds.size() != points.size()) {
+		tileIds = Kokkos::View<IdType*, MemorySpace>(
+			AllocNoInit{"Tile Ids"}, numPoints);
+	}
+	auto ids = tileIds;
+
+	// Order the searches along a Morton curve through the lattice
+	Kokkos::View<IdType*, MemorySpace> order;
+	bool sorted = sortPoints && numPoints > 1;
+	if (sorted) {
+		order = getCurveOrder(
+			numPoints, KOKKOS_LAMBDA(IdType i) { return points(i); },
+			SpaceFillingCurve::morton);
+	}
+
+	auto subpaving = *this;
+	IdType numNotFound = 0;
+	Kokkos::parallel_reduce(
+		"FindTileIds", numPoints,
+		KOKKOS_LAMBDA(IdType i, IdType & running) {
+			auto pointId = sorted ? order(i) : i;
+			auto tileId = subpaving.findTileId(points(pointId));
+			ids(pointId) = tileId;
+			if (tileId == invalid<IdType>) {
+				++running;
+			}
+		},
+		numNotFound);
+	Kokkos::fence();
+
+	return numNotFound;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TVisitor>
+KOKKOS_INLINE_FUNCTION
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::visitTilesIntersecting(
+	const RegionType& region, TVisitor&& visitor) const
+{
+	if (region.intersects(_rootRegion)) {
+		visitTilesIntersectingIn(0, _rootRegion, region, visitor);
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TVisitor>
+KOKKOS_INLINE_FUNCTION
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::visitTilesIntersectingIn(
+	IdType startZoneId, const RegionType& startZoneRegion,
+	const RegionType& region, TVisitor&& visitor) const
+{
+	const auto& zones = _zonesRA;
+	const auto& infos = _subdivisionInfos;
+
+	// Find the first sub-zone of zone from subZoneId on which intersects the
+	// region (or the end of its sub-zones)
+	auto findNext = [&](const auto& zone, const RegionType& zoneRegion,
+						IdType subZoneId, RegionType& subZoneRegion) {
+		const auto& levelInfo = infos(zone.getLevel());
+		auto end = zone.getSubZoneIndices().end();
+		for (; subZoneId < end; ++subZoneId) {
+			subZoneRegion = detail::getChildZoneRegion(
+				zones, zone, zoneRegion, subZoneId, levelInfo);
+			if (subZoneRegion.intersects(region)) {
+				break;
+			}
+		}
+		return subZoneId;
+	};
+
+	IdType zoneId = startZoneId;
+	auto zoneRegion = startZoneRegion;
+	bool entering = true;
+	for (;;) {
+		const auto& zone = zones(zoneId);
+		if (entering) {
+			if (zone.hasTile()) {
+				visitor(zone.getTileIndex(), zoneRegion);
+			}
+			else if (!zone.getSubZoneIndices().empty()) {
+				RegionType subZoneRegion;
+				auto subZoneId = findNext(zone, zoneRegion,
+					zone.getSubZoneIndices().begin(), subZoneRegion);
+				if (subZoneId < zone.getSubZoneIndices().end()) {
+					zoneId = subZoneId;
+					zoneRegion = subZoneRegion;
+					continue;
+				}
+			}
+		}
+
+		// Done with this zone: move on to the next sibling intersecting the
+		// region, or else back up to the parent
+		if (zoneId == startZoneId) {
+			break;
+		}
+		auto parentId = zone.getParentIndex();
+		const auto& parent = zones(parentId);
+		auto parentRegion =
+			detail::getParentZoneRegion(zones, zone, infos, zoneRegion);
+		RegionType siblingRegion;
+		auto siblingId =
+			findNext(parent, parentRegion, zoneId + 1, siblingRegion);
+		if (siblingId < parent.getSubZoneIndices().end()) {
+			zoneId = siblingId;
+			zoneRegion = siblingRegion;
+			entering = true;
+		}
+		else {
+			zoneId = parentId;
+			zoneRegion = parentRegion;
+			entering = false;
+		}
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+KOKKOS_INLINE_FUNCTION
+IdType
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::countTilesIntersecting(
+	const RegionType& region) const
+{
+	IdType ret = 0;
+	visitTilesIntersecting(
+		region, [&ret](IdType, const RegionType&) { ++ret; });
+	return ret;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+IdType
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findTilesIntersecting(
+	const RegionType& region) const
+{
+	return searchTilesIntersecting(region, nullptr);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+IdType
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findTilesIntersecting(
+	const RegionType& region, Kokkos::View<IdType*, MemorySpace>& tileIds) const
+{
+	return searchTilesIntersecting(region, &tileIds);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+IdType
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findTilesIntersecting(
+	const Kokkos::View<RegionType*, MemorySpace>& regions,
+	Kokkos::View<IdType*, MemorySpace>& offsets,
+	Kokkos::View<IdType*, MemorySpace>& tileIds) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+	auto numRegions = static_cast<IdType>(regions.size());
+	if (offsets.size() != regions.size() + 1) {
+		offsets = Kokkos::View<IdType*, MemorySpace>(
+			AllocNoInit{"Tile Offsets"}, numRegions + 1);
+	}
+	auto starts = offsets;
+	auto subpaving = *this;
+
+	// Count the tiles found for each region, then turn the counts into
+	// offsets
+	Kokkos::parallel_for(
+		"CountTilesIntersecting", numRegions, KOKKOS_LAMBDA(IdType i) {
+			starts(i) = subpaving.countTilesIntersecting(regions(i));
+		});
+	IdType numFound = 0;
+	Kokkos::parallel_scan(
+		"ScanTilesIntersecting", numRegions + 1,
+		KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+			auto count = (i < numRegions) ? starts(i) : 0;
+			if (finalPass) {
+				starts(i) = update;
+			}
+			update += count;
+		},
+		numFound);
+	Kokkos::fence();
+
+	if (tileIds.size() != static_cast<std::size_t>(numFound)) {
+		tileIds = Kokkos::View<IdType*, MemorySpace>(
+			AllocNoInit{"Tile Ids"}, numFound);
+	}
+	auto ids = tileIds;
+	Kokkos::parallel_for(
+		"CollectTilesIntersecting", numRegions, KOKKOS_LAMBDA(IdType i) {
+			auto pos = starts(i);
+			subpaving.visitTilesIntersecting(regions(i),
+				[&](IdType tileId, const RegionType&) { ids(pos++) = tileId; });
+		});
+	Kokkos::fence();
+
+	return numFound;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findSumOverlaps(
+	const Kokkos::View<IdType*, MemorySpace>& firstTileIds,
+	const Kokkos::View<IdType*, MemorySpace>& secondTileIds,
+	SumOverlapsType& overlaps) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using IdsView = typename SumOverlapsType::IdsView;
+	using VolumesView = typename SumOverlapsType::VolumesView;
+
+	if (firstTileIds.size() != secondTileIds.size()) {
+		throw std::invalid_argument(
+			"Subpaving: numbers of first and second tiles of pairs (" +
+			std::to_string(firstTileIds.size()) + " and " +
+			std::to_string(secondTileIds.size()) + ") do not match");
+	}
+
+	// Count the overlaps for each pair, then turn the counts into offsets
+	auto numPairs = static_cast<IdType>(firstTileIds.size());
+	auto offsets = IdsView(AllocNoInit{"Sum Overlap Offsets"}, numPairs + 1);
+	auto subpaving = *this;
+	Kokkos::parallel_for(
+		"CountSumOverlaps", numPairs, KOKKOS_LAMBDA(IdType i) {
+			offsets(i) = subpaving.countTilesIntersecting(
+				getSumRegion(subpaving.getTileRegion(firstTileIds(i)),
+					subpaving.getTileRegion(secondTileIds(i))));
+		});
+	IdType numOverlaps = 0;
+	Kokkos::parallel_scan(
+		"ScanSumOverlaps", numPairs + 1,
+		KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+			auto count = (i < numPairs) ? offsets(i) : 0;
+			if (finalPass) {
+				offsets(i) = update;
+			}
+			update += count;
+		},
+		numOverlaps);
+	Kokkos::fence();
+
+	auto tileIds = IdsView(AllocNoInit{"Sum Overlap Tile Ids"}, numOverlaps);
+	auto volumes =
+		VolumesView(AllocNoInit{"Sum Overlap Volumes"}, numOverlaps);
+	Kokkos::parallel_for(
+		"CollectSumOverlaps", numPairs, KOKKOS_LAMBDA(IdType i) {
+			auto sumRegion =
+				getSumRegion(subpaving.getTileRegion(firstTileIds(i)),
+					subpaving.getTileRegion(secondTileIds(i)));
+			auto pos = offsets(i);
+			subpaving.visitTilesIntersecting(sumRegion,
+				[&](IdType tileId, const RegionType& tileRegion) {
+					tileIds(pos) = tileId;
+					volumes(pos) = getOverlapVolume(tileRegion, sumRegion);
+					++pos;
+				});
+		});
+	Kokkos::fence();
+
+	overlaps =
+		SumOverlapsType{firstTileIds, secondTileIds, offsets, tileIds, volumes};
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TPredicate>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findSumOverlaps(
+	const TPredicate& predicate, SumOverlapsType& overlaps) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using IdsView = typename SumOverlapsType::IdsView;
+
+	// Offer each pair (a, b) with a <= b once, through its position in the
+	// flattened triangle of pairs, and mark the accepted ones
+	auto numTiles = getNumberOfTiles();
+	auto numCandidates = static_cast<std::uint64_t>(numTiles) *
+		(static_cast<std::uint64_t>(numTiles) + 1) / 2;
+	if (numCandidates > std::numeric_limits<unsigned>::max()) {
+		throw std::invalid_argument("Subpaving: too many pairs of tiles (" +
+			std::to_string(numCandidates) + ") to offer to a predicate");
+	}
+	auto numPairsToTest = static_cast<IdType>(numCandidates);
+	auto accepted =
+		Kokkos::Bitset<DefaultExecSpace>(static_cast<unsigned>(numCandidates));
+	IdType numPairs = 0;
+	Kokkos::parallel_reduce(
+		"CountTilePairs", numPairsToTest,
+		KOKKOS_LAMBDA(IdType i, IdType & running) {
+			auto pair = getTilePair(numTiles, i);
+			if (predicate(pair.first, pair.second)) {
+				accepted.set(static_cast<unsigned>(i));
+				++running;
+			}
+		},
+		numPairs);
+	Kokkos::fence();
+
+	// List the accepted pairs in order
+	auto firstTileIds = IdsView(AllocNoInit{"First Tile Ids"}, numPairs);
+	auto secondTileIds = IdsView(AllocNoInit{"Second Tile Ids"}, numPairs);
+	Kokkos::parallel_scan(
+		"CollectTilePairs", numPairsToTest,
+		KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+			if (!accepted.test(static_cast<unsigned>(i))) {
+				return;
+			}
+			if (finalPass) {
+				auto pair = getTilePair(numTiles, i);
+				firstTileIds(update) = pair.first;
+				secondTileIds(update) = pair.second;
+			}
+			++update;
+		},
+		numPairs);
+	Kokkos::fence();
+
+	findSumOverlaps(firstTileIds, secondTileIds, overlaps);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TVisitor>
+KOKKOS_INLINE_FUNCTION
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::visitFaceNeighbors(
+	IdType tileId, TVisitor&& visitor) const
+{
+	const auto& zones = _zonesRA;
+	const auto& infos = _subdivisionInfos;
+	auto zoneId = _tilesRA(tileId).getOwningZoneIndex();
+	auto region = getZoneRegion(zoneId);
+	for (DimType i = 0; i < Dim; ++i) {
+		const auto& ival = region[i];
+		for (int side = 0; side < 2; ++side) {
+			bool upper = (side == 1);
+			// The layer just outside the face, unless the face is on the
+			// boundary of the lattice
+			auto layer = region;
+			if (upper) {
+				if (ival.end() == _rootRegion[i].end()) {
+					continue;
+				}
+				layer[i] = IntervalType{
+					ival.end(), static_cast<ScalarType>(ival.end() + 1)};
+			}
+			else {
+				if (ival.begin() == _rootRegion[i].begin()) {
+					continue;
+				}
+				layer[i] = IntervalType{
+					static_cast<ScalarType>(ival.begin() - 1), ival.begin()};
+			}
+			// Search from the nearest zone enclosing the layer, which is
+			// usually a close ancestor
+			auto ancestorId = zoneId;
+			auto ancestorRegion = region;
+			while (!ancestorRegion[i].contains(layer[i].begin())) {
+				const auto& ancestor = zones(ancestorId);
+				ancestorRegion = detail::getParentZoneRegion(
+					zones, ancestor, infos, ancestorRegion);
+				ancestorId = ancestor.getParentIndex();
+			}
+			// The overlap with the layer is one point thick, so its volume
+			// is the area of the shared face
+			visitTilesIntersectingIn(ancestorId, ancestorRegion, layer,
+				[&](IdType neighborId, const RegionType& neighborRegion) {
+					auto faceArea = getOverlapVolume(neighborRegion, layer);
+					visitor(neighborId, faceArea);
+				});
+		}
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::findFaceNeighbors(
+	TileAdjacencyType& adjacency) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using IdsView = typename TileAdjacencyType::IdsView;
+	using AreasView = typename TileAdjacencyType::AreasView;
+
+	// Count the neighbors of each tile, then turn the counts into offsets
+	auto numTiles = getNumberOfTiles();
+	auto rowMap = IdsView(AllocNoInit{"Tile Adjacency Row Map"}, numTiles + 1);
+	auto subpaving = *this;
+	Kokkos::parallel_for(
+		"CountFaceNeighbors", numTiles, KOKKOS_LAMBDA(IdType i) {
+			IdType count = 0;
+			subpaving.visitFaceNeighbors(
+				i, [&count](IdType, double) { ++count; });
+			rowMap(i) = count;
+		});
+	IdType numEdges = 0;
+	Kokkos::parallel_scan(
+		"ScanFaceNeighbors", numTiles + 1,
+		KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+			auto count = (i < numTiles) ? rowMap(i) : 0;
+			if (finalPass) {
+				rowMap(i) = update;
+			}
+			update += count;
+		},
+		numEdges);
+	Kokkos::fence();
+
+	auto entries = IdsView(AllocNoInit{"Tile Adjacency Entries"}, numEdges);
+	auto faceAreas =
+		AreasView(AllocNoInit{"Tile Adjacency Face Areas"}, numEdges);
+	Kokkos::parallel_for(
+		"CollectFaceNeighbors", numTiles, KOKKOS_LAMBDA(IdType i) {
+			auto pos = rowMap(i);
+			subpaving.visitFaceNeighbors(
+				i, [&](IdType neighborId, double faceArea) {
+					entries(pos) = neighborId;
+					faceAreas(pos) = faceArea;
+					++pos;
+				});
+		});
+	Kokkos::fence();
+
+	adjacency = TileAdjacencyType{rowMap, entries, faceAreas};
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TVisitor>
+KOKKOS_INLINE_FUNCTION
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::visitSubZonesIntersecting(
+	const ZonesRAView& zones,
+	const Kokkos::View<detail::SubdivisionInfo<Dim>*, MemorySpace>& infos,
+	IdType zoneId, const RegionType& zoneRegion, const RegionType& region,
+	TVisitor&& visitor)
+{
+	const auto& zone = zones(zoneId);
+	if (zone.getSubZoneIndices().empty()) {
+		return;
+	}
+	const auto& levelInfo = infos(zone.getLevel());
+	for (auto j : zone.getSubZoneRange()) {
+		auto subZoneRegion =
+			detail::getChildZoneRegion(zones, zone, zoneRegion, j, levelInfo);
+		if (subZoneRegion.intersects(region)) {
+			visitor(j, subZoneRegion);
+		}
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+IdType
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::searchTilesIntersecting(
+	const RegionType& region, Kokkos::View<IdType*, MemorySpace>* tileIds) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+	using RegionsView = Kokkos::View<RegionType*, MemorySpace>;
+
+	auto zones = _zonesRA;
+	auto infos = _subdivisionInfos;
+
+	// The frontier holds the zones at the current level which intersect the
+	// region, with their regions (which may not be stored in the zones)
+	IdType numFrontier = region.intersects(_rootRegion) ? 1 : 0;
+	auto frontier = IdsView("Frontier Zones", numFrontier);
+	auto frontierRegions =
+		RegionsView(AllocNoInit{"Frontier Zone Regions"}, numFrontier);
+	deep_copy(frontierRegions, _rootRegion);
+
+	std::vector<IdsView> levelTileIds;
+	IdType numFound = 0;
+	while (numFrontier > 0) {
+		// Collect (or count) the tiles of the frontier zones
+		IdType numTiles = 0;
+		if (tileIds != nullptr) {
+			auto tileStarts = IdsView(AllocNoInit{"Tile Starts"}, numFrontier);
+			Kokkos::parallel_scan(
+				"ScanTilesIntersecting", numFrontier,
+				KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+					if (finalPass) {
+						tileStarts(i) = update;
+					}
+					if (zones(frontier(i)).hasTile()) {
+						++update;
+					}
+				},
+				numTiles);
+			Kokkos::fence();
+			auto found = IdsView(AllocNoInit{"Tiles Found"}, numTiles);
+			Kokkos::parallel_for(
+				"CollectTilesIntersecting", numFrontier,
+				KOKKOS_LAMBDA(IdType i) {
+					const auto& zone = zones(frontier(i));
+					if (zone.hasTile()) {
+						found(tileStarts(i)) = zone.getTileIndex();
+					}
+				});
+			levelTileIds.push_back(found);
+		}
+		else {
+			Kokkos::parallel_reduce(
+				"CountTilesIntersecting", numFrontier,
+				KOKKOS_LAMBDA(IdType i, IdType & running) {
+					if (zones(frontier(i)).hasTile()) {
+						++running;
+					}
+				},
+				numTiles);
+		}
+		numFound += numTiles;
+
+		// Find the sub-zones of the frontier zones which intersect the region
+		auto subZoneStarts =
+			IdsView(AllocNoInit{"Sub-Zone Starts"}, numFrontier);
+		IdType numNext = 0;
+		Kokkos::parallel_scan(
+			"ScanZonesIntersecting", numFrontier,
+			KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+				if (finalPass) {
+					subZoneStarts(i) = update;
+				}
+				visitSubZonesIntersecting(zones, infos, frontier(i),
+					frontierRegions(i), region,
+					[&](IdType, const RegionType&) { ++update; });
+			},
+			numNext);
+		Kokkos::fence();
+		auto next = IdsView(AllocNoInit{"Frontier Zones"}, numNext);
+		auto nextRegions =
+			RegionsView(AllocNoInit{"Frontier Zone Regions"}, numNext);
+		Kokkos::parallel_for(
+			"CollectZonesIntersecting", numFrontier, KOKKOS_LAMBDA(IdType i) {
+				auto pos = subZoneStarts(i);
+				visitSubZonesIntersecting(zones, infos, frontier(i),
+					frontierRegions(i), region,
+					[&](IdType subZoneId, const RegionType& subZoneRegion) {
+						next(pos) = subZoneId;
+						nextRegions(pos) = subZoneRegion;
+						++pos;
+					});
+			});
+		Kokkos::fence();
+		frontier = next;
+		frontierRegions = nextRegions;
+		numFrontier = numNext;
+	}
+
+	if (tileIds != nullptr) {
+		if (tileIds->size() != static_cast<std::size_t>(numFound)) {
+			*tileIds = IdsView(AllocNoInit{"Tile Ids"}, numFound);
+		}
+		std::size_t begin = 0;
+		for (const auto& found : levelTileIds) {
+			auto end = begin + found.size();
+			deep_copy(Kokkos::subview(*tileIds, std::make_pair(begin, end)),
+				found);
+			begin = end;
+		}
+	}
+
+	return numFound;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+Kokkos::View<IdType*, TMemSpace>
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::reorderTiles(
+	SpaceFillingCurve curve)
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+	checkTileAttributes();
+	auto numTiles = getNumberOfTiles();
+	auto tiles = _tilesRA;
+	auto subpaving = *this;
+	auto order = getCurveOrder(
+		numTiles,
+		KOKKOS_LAMBDA(IdType i) {
+			return subpaving.getTileRegion(i).getOrigin();
+		},
+		curve);
+
+	// Each zone owns at most one tile, so the zones can be updated at the
+	// same time
+	auto zones = _zones;
+	auto itemData = _itemData;
+	auto newTiles = TilesView(AllocNoInit{"Reordered Tiles"}, numTiles);
+	auto newItemData =
+		ItemDataView(AllocNoInit{"Reordered Item Data"}, numTiles);
+	Kokkos::parallel_for(
+		"ReorderTiles", numTiles, KOKKOS_LAMBDA(IdType i) {
+			const auto& tile = tiles(order(i));
+			newTiles(i) = tile;
+			newItemData(i) = itemData(order(i));
+			zones(tile.getOwningZoneIndex()).setTileIndex(i);
+		});
+	Kokkos::fence();
+	deep_copy(_tiles, newTiles);
+	deep_copy(_itemData, newItemData);
+	if (_tileAttributes != nullptr) {
+		_tileAttributes->permute(order);
+	}
+
+	return order;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::setTileAttributes(
+	TileAttributes<MemorySpace>* attributes)
+{
+	if (attributes != nullptr &&
+		attributes->getNumberOfTiles() != getNumberOfTiles()) {
+		throw std::invalid_argument(
+			"Subpaving: tile attributes are not sized for the tiles");
+	}
+	_tileAttributes = attributes;
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+void
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::checkTileAttributes()
+	const
+{
+	if (_tileAttributes != nullptr &&
+		_tileAttributes->getNumberOfTiles() != getNumberOfTiles()) {
+		throw std::invalid_argument(
+			"Subpaving: tile attributes are not sized for the tiles");
+	}
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TGetPoint>
+Kokkos::View<IdType*, TMemSpace>
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::getCurveOrder(
+	IdType numPoints, const TGetPoint& getPoint, SpaceFillingCurve curve) const
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using KeysView = Kokkos::View<std::uint64_t*, MemorySpace>;
+	using KeyRange = Kokkos::MinMaxScalar<std::uint64_t>;
+
+	std::uint64_t maxExtent = 0;
+	for (auto i : makeIntervalRange(Dim)) {
+		maxExtent =
+			std::max<std::uint64_t>(maxExtent, _rootRegion[i].length());
+	}
+	auto shift = detail::getCurveKeyShift<Dim>(maxExtent);
+	auto rootRegion = _rootRegion;
+	auto keys = KeysView(AllocNoInit{"Curve Keys"}, numPoints);
+	KeyRange keyRange{};
+	Kokkos::parallel_reduce(
+		"ComputeCurveKeys", numPoints,
+		KOKKOS_LAMBDA(IdType i, KeyRange & range) {
+			auto key = detail::getCurveKey<Dim>(curve,
+				detail::getCurveCoordinates(rootRegion, getPoint(i), shift));
+			keys(i) = key;
+			range.min_val = (key < range.min_val) ? key : range.min_val;
+			range.max_val = (key > range.max_val) ? key : range.max_val;
+		},
+		Kokkos::MinMax<std::uint64_t>(keyRange));
+	Kokkos::fence();
+
+	return getSortedOrder(keys, keyRange);
+}
+
+template <typename TScalar, DimType Dim, typename TEnum, typename TItemData,
+	typename TMemSpace>
+template <typename TKeys, typename TKeyRange>
+Kokkos::View<IdType*, TMemSpace>
+Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>::getSortedOrder(
+	const TKeys& keys, const TKeyRange& keyRange)
+{
+	using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+	using BinSort = Kokkos::BinSort<TKeys, Kokkos::BinOp1D<TKeys>>;
+
+	auto numKeys = static_cast<IdType>(keys.size());
+	auto order = Kokkos::View<IdType*, MemorySpace>(
+		AllocNoInit{"Sorted Order"}, numKeys);
+	if (numKeys < 2 || keyRange.min_val == keyRange.max_val) {
+		Kokkos::parallel_for(
+			"InitializeSortedOrder", numKeys,
+			KOKKOS_LAMBDA(IdType i) { order(i) = i; });
+		Kokkos::fence();
+		return order;
+	}
+
+	auto binOp = Kokkos::BinOp1D<TKeys>(
+		static_cast<int>(numKeys / 2), keyRange.min_val, keyRange.max_val);
+	auto binSort = BinSort(keys, binOp, true);
+	binSort.create_permute_vector();
+	auto permutation = binSort.get_permute_vector();
+	Kokkos::parallel_for(
+		"CopySortedOrder", numKeys, KOKKOS_LAMBDA(IdType i) {
+			order(i) = static_cast<IdType>(permutation(i));
+		});
+	Kokkos::fence();
+
+	return order;
 }
 } // namespace plsm
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Kokkos_Core.hpp>
+
+#include <plsm/IntervalRange.h>
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+/*!
+ * @brief Get the (lattice) sum of two regions: the region holding every
+ * point a + b for a point a in the first region and b in the second
+ *
+ * Along each axis this is [a.begin() + b.begin(), a.end() + b.end() - 1).
+ */
+template <typename TRegion>
+KOKKOS_INLINE_FUNCTION
+TRegion
+getSumRegion(const TRegion& a, const TRegion& b)
+{
+	using ScalarType = typename TRegion::ScalarType;
+	using IntervalType = typename TRegion::IntervalType;
+	TRegion ret;
+	for (auto i : makeIntervalRange(TRegion::dimension())) {
+		ret[i] =
+			IntervalType{static_cast<ScalarType>(a[i].begin() + b[i].begin()),
+				static_cast<ScalarType>(a[i].end() + b[i].end() - 1)};
+	}
+	return ret;
+}
+
+/*!
+ * @brief Get the volume (the number of lattice points) of the overlap of two
+ * regions
+ */
+template <typename TRegion>
+KOKKOS_INLINE_FUNCTION
+double
+getOverlapVolume(const TRegion& a, const TRegion& b)
+{
+	double ret{1.0};
+	for (auto i : makeIntervalRange(TRegion::dimension())) {
+		const auto& ai = a[i];
+		const auto& bi = b[i];
+		auto begin = (ai.begin() < bi.begin()) ? bi.begin() : ai.begin();
+		auto end = (ai.end() < bi.end()) ? ai.end() : bi.end();
+		if (!(begin < end)) {
+			return 0.0;
+		}
+		ret *= (double)(end - begin);
+	}
+	return ret;
+}
+
+/*!
+ * @brief Get the pair of tile ids (a, b) with a <= b at the given position
+ * in the list of all such pairs of numTiles tiles, ordered by a and then by
+ * b
+ *
+ * Row a of the list starts at a * numTiles - a * (a - 1) / 2, so the row is
+ * found by a binary search over the rows.
+ */
+KOKKOS_INLINE_FUNCTION
+Kokkos::pair<IdType, IdType>
+getTilePair(IdType numTiles, std::uint64_t pairIndex)
+{
+	auto n = static_cast<std::uint64_t>(numTiles);
+	auto getRowStart = [n](std::uint64_t row) {
+		return row * n - row * (row - 1) / 2;
+	};
+	std::uint64_t a = 0;
+	std::uint64_t end = n;
+	while (end - a > 1) {
+		auto mid = a + (end - a) / 2;
+		if (getRowStart(mid) <= pairIndex) {
+			a = mid;
+		}
+		else {
+			end = mid;
+		}
+	}
+	auto b = a + (pairIndex - getRowStart(a));
+	return {static_cast<IdType>(a), static_cast<IdType>(b)};
+}
+
+/*!
+ * @brief SumOverlaps relates pairs of tiles (A, B) of a Subpaving to the
+ * tiles C which overlap the sum of their regions (see getSumRegion()), with
+ * the volume of each overlap
+ *
+ * The overlaps are stored in compressed sparse row form: those for pair p
+ * are entries offsets(p) up to offsets(p + 1) of the tile ids and overlap
+ * volumes.
+ *
+ * @test unittest_Subpaving.cpp
+ */
+template <typename TMemSpace = DefaultMemSpace>
+class SumOverlaps
+{
+public:
+	//! The memory space for the overlap data
+	using MemorySpace = TMemSpace;
+	//! Type for tile ids and offsets
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+	//! Type for overlap volumes
+	using VolumesView = Kokkos::View<double*, MemorySpace>;
+
+	SumOverlaps() = default;
+
+	/*!
+	 * @brief Construct from the tiles of each pair and the overlaps (in
+	 * compressed sparse row form)
+	 */
+	SumOverlaps(const IdsView& firstTileIds, const IdsView& secondTileIds,
+		const IdsView& offsets, const IdsView& tileIds,
+		const VolumesView& overlapVolumes) :
+		_firstTileIds(firstTileIds),
+		_secondTileIds(secondTileIds),
+		_offsets(offsets),
+		_tileIds(tileIds),
+		_overlapVolumes(overlapVolumes)
+	{
+	}
+
+	/*!
+	 * @brief Get the number of pairs of tiles
+	 */
+	IdType
+	getNumberOfPairs() const noexcept
+	{
+		return static_cast<IdType>(_firstTileIds.size());
+	}
+
+	/*!
+	 * @brief Get the total number of overlaps (over all pairs)
+	 */
+	IdType
+	getNumberOfOverlaps() const noexcept
+	{
+		return static_cast<IdType>(_tileIds.size());
+	}
+
+	/*!
+	 * @brief Get the first tile (A) of each pair
+	 */
+	const IdsView&
+	getFirstTileIds() const noexcept
+	{
+		return _firstTileIds;
+	}
+
+	/*!
+	 * @brief Get the second tile (B) of each pair
+	 */
+	const IdsView&
+	getSecondTileIds() const noexcept
+	{
+		return _secondTileIds;
+	}
+
+	/*!
+	 * @brief Get the start of the overlaps for each pair (with one more entry
+	 * for the end)
+	 */
+	const IdsView&
+	getOffsets() const noexcept
+	{
+		return _offsets;
+	}
+
+	/*!
+	 * @brief Get the overlapping tile (C) of each overlap
+	 */
+	const IdsView&
+	getTileIds() const noexcept
+	{
+		return _tileIds;
+	}
+
+	/*!
+	 * @brief Get the volume of each overlap (the number of lattice points in
+	 * both the tile and the sum region of its pair)
+	 */
+	const VolumesView&
+	getOverlapVolumes() const noexcept
+	{
+		return _overlapVolumes;
+	}
+
+private:
+	//! First tile of each pair
+	IdsView _firstTileIds;
+	//! Second tile of each pair
+	IdsView _secondTileIds;
+	//! Start of the overlaps for each pair
+	IdsView _offsets;
+	//! Overlapping tile of each overlap
+	IdsView _tileIds;
+	//! Volume of each overlap
+	VolumesView _overlapVolumes;
+};
+} // namespace plsm
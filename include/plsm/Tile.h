@@ -8,19 +8,152 @@
 
 namespace plsm
 {
+/*!
+ * @brief How the item data of the tiles produced by refining a tile is
+ * initialized (see Subpaving::setItemDataInit())
+ */
+enum class ItemDataInit
+{
+	//! Each new tile gets a copy of the data of the tile it was refined from
+	copyParent,
+	//! Each new tile (and the refined tile) gets value-initialized data
+	reset
+};
+
+namespace detail
+{
+/*!
+ * @brief Holds the data item mapped from a Tile (nothing for void)
+ *
+ * This is a base of Tile, so that a Tile without data (which is what a
+ * Subpaving stores, keeping the data in a separate view) takes no space
+ * for it.
+ */
+template <typename TItemData>
+class TileData
+{
+public:
+	static_assert(std::is_trivially_copyable_v<TItemData>,
+		"Tile data must be trivially copyable");
+
+	//! User data type to be mapped from Tile
+	using ItemDataType = TItemData;
+
+	/*!
+	 * @brief Check if the Tile has mapped data (only for arithmetic data,
+	 * which is invalid until set)
+	 */
+	template <typename T = ItemDataType,
+		std::enable_if_t<std::is_arithmetic<T>{}, int> = 0>
+	KOKKOS_INLINE_FUNCTION
+	bool
+	hasData() const noexcept
+	{
+		return _data != invalid<ItemDataType>;
+	}
+
+	//!@{
+	/*!
+	 * @brief Get/Set mapped data item
+	 */
+	KOKKOS_INLINE_FUNCTION
+	ItemDataType&
+	getData() noexcept
+	{
+		return _data;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	const ItemDataType&
+	getData() const noexcept
+	{
+		return _data;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	void
+	setData(const ItemDataType& data)
+	{
+		_data = data;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	void
+	setData(ItemDataType&& data)
+	{
+		_data = std::move(data);
+	}
+	//!@}
+
+private:
+	static constexpr ItemDataType
+	getInitialData() noexcept
+	{
+		if constexpr (std::is_arithmetic_v<ItemDataType>) {
+			return invalid<ItemDataType>;
+		}
+		else {
+			return ItemDataType{};
+		}
+	}
+
+	//! Mapped user data item
+	ItemDataType _data{getInitialData()};
+};
+
+template <>
+class TileData<void>
+{
+public:
+	using ItemDataType = void;
+
+	//!@{
+	/*!
+	 * @brief Tiles without data have no data accessors
+	 *
+	 * These only exist to explain the compile error for code written when
+	 * the tiles of a Subpaving held their data. A Subpaving now keeps the
+	 * data apart from its tiles.
+	 */
+	template <typename T = void>
+	KOKKOS_INLINE_FUNCTION
+	void
+	getData() const noexcept
+	{
+		static_assert(sizeof(T*) == 0,
+			"Tile has no data; use Subpaving::getTileData() instead");
+	}
+
+	template <typename T>
+	KOKKOS_INLINE_FUNCTION
+	void
+	setData(const T&) noexcept
+	{
+		static_assert(sizeof(T*) == 0,
+			"Tile has no data; use Subpaving::setTileData() instead");
+	}
+	//!@}
+};
+} // namespace detail
+
 /*!
  * @brief Tile is used as a non-overlapped lattice region
  *
  * Tile expects to be used in a Subpaving and to "owned" by an existing Zone in
  * that Subpaving.
  *
+ * If PLSM_USE_COMPACT_TILES is defined, the Tile does not store its Region,
+ * which is always the Region of the owning Zone (see
+ * Subpaving::getTileRegion()). This saves 2 * Dim scalars per tile.
+ *
  * @tparam TRegion Type used for lattice region
- * @tparam TItemData User data type to be mapped from Tile
+ * @tparam TItemData User data type to be mapped from Tile (any trivially
+ * copyable type, or void for none)
  *
  * @test test_Tile.cpp
  */
 template <typename TRegion, typename TItemData = IdType>
-class Tile
+class Tile : public detail::TileData<TItemData>
 {
 public:
 	//! Alias for Region
@@ -33,6 +166,17 @@ public:
 	 */
 	Tile() = default;
 
+#if defined(PLSM_USE_COMPACT_TILES)
+	/*!
+	 * @brief Construct with Region and owning Zone index
+	 *
+	 * The Region is not stored, since it is that of the owning Zone.
+	 */
+	KOKKOS_INLINE_FUNCTION
+	Tile(const RegionType&, IdType owningZoneId) : _owningZoneId(owningZoneId)
+	{
+	}
+#else
 	/*!
 	 * @brief Construct with Region and owning Zone index
 	 */
@@ -52,6 +196,7 @@ public:
 	{
 		return _region;
 	}
+#endif
 
 	KOKKOS_INLINE_FUNCTION
 	bool
@@ -80,60 +225,12 @@ public:
 	}
 	//!@}
 
-	/*!
-	 * @brief Check if the Tile has mapped data
-	 */
-	KOKKOS_INLINE_FUNCTION
-	bool
-	hasData() const noexcept
-	{
-		return _data != invalid<ItemDataType>;
-	}
-
-	//!@{
-	/*!
-	 * @brief Get/Set mapped data item
-	 */
-	KOKKOS_INLINE_FUNCTION
-	ItemDataType&
-	getData() noexcept
-	{
-		return _data;
-	}
-
-	KOKKOS_INLINE_FUNCTION
-	const ItemDataType&
-	getData() const noexcept
-	{
-		return _data;
-	}
-
-	KOKKOS_INLINE_FUNCTION
-	void
-	setData(const ItemDataType& data)
-	{
-		_data = data;
-	}
-
-	KOKKOS_INLINE_FUNCTION
-	void
-	setData(ItemDataType&& data)
-	{
-		_data = std::move(data);
-	}
-	//!@}
-
 private:
+#if !defined(PLSM_USE_COMPACT_TILES)
 	//! Region mapped from by this Tile
 	RegionType _region;
+#endif
 	//! Index of owning Zone
 	IdType _owningZoneId{invalid<IdType>};
-
-	// FIXME: Idea would be to use optional<ItemDataType> to hold arbitrary
-	// data in a Tile. It needs to be initialized to an invalid state.
-	static_assert(
-		std::is_same<ItemDataType, IdType>{}, "Only IdType supported for now");
-	//! Mapped user data item
-	ItemDataType _data{invalid<ItemDataType>};
 };
 } // namespace plsm
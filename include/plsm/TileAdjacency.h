@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Kokkos_Core.hpp>
+
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+/*!
+ * @brief TileAdjacency is the graph of the tiles of a Subpaving which share
+ * a face, with the area of each shared face (see
+ * Subpaving::findFaceNeighbors())
+ *
+ * The graph is stored in compressed sparse row form, with the same layout as
+ * a Kokkos Kernels graph (row map and entries) and matrix values: the
+ * neighbors of tile i are entries rowMap(i) up to rowMap(i + 1) of the
+ * entries and face areas. Each shared face appears in the rows of both of
+ * its tiles.
+ *
+ * @test unittest_Subpaving.cpp
+ */
+template <typename TMemSpace = DefaultMemSpace>
+class TileAdjacency
+{
+public:
+	//! The memory space for the adjacency data
+	using MemorySpace = TMemSpace;
+	//! Type for row offsets and tile ids
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+	//! Type for face areas
+	using AreasView = Kokkos::View<double*, MemorySpace>;
+
+	TileAdjacency() = default;
+
+	/*!
+	 * @brief Construct from row offsets, neighbor tile ids, and face areas
+	 */
+	TileAdjacency(const IdsView& rowMap, const IdsView& entries,
+		const AreasView& faceAreas) :
+		_rowMap(rowMap), _entries(entries), _faceAreas(faceAreas)
+	{
+	}
+
+	/*!
+	 * @brief Get the number of tiles (rows)
+	 */
+	IdType
+	getNumberOfTiles() const noexcept
+	{
+		auto numRows = _rowMap.size();
+		return (numRows == 0) ? 0 : static_cast<IdType>(numRows - 1);
+	}
+
+	/*!
+	 * @brief Get the number of edges (counting each shared face twice)
+	 */
+	IdType
+	getNumberOfEdges() const noexcept
+	{
+		return static_cast<IdType>(_entries.size());
+	}
+
+	/*!
+	 * @brief Get the start of the neighbors of each tile (with one more entry
+	 * for the end)
+	 */
+	const IdsView&
+	getRowMap() const noexcept
+	{
+		return _rowMap;
+	}
+
+	/*!
+	 * @brief Get the neighboring tile of each edge
+	 */
+	const IdsView&
+	getEntries() const noexcept
+	{
+		return _entries;
+	}
+
+	/*!
+	 * @brief Get the area of the shared face of each edge (the number of
+	 * lattice points across the face)
+	 */
+	const AreasView&
+	getFaceAreas() const noexcept
+	{
+		return _faceAreas;
+	}
+
+private:
+	//! Start of the neighbors of each tile
+	IdsView _rowMap;
+	//! Neighboring tile of each edge
+	IdsView _entries;
+	//! Area of the shared face of each edge
+	AreasView _faceAreas;
+};
+} // namespace plsm
@@ -0,0 +1,532 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <Kokkos_Core.hpp>
+
+#include <plsm/Prolongation.h>
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+/*!
+ * @brief How a tile attribute is carried over when tiles are refined or
+ * merged (see TileAttributes::add())
+ */
+enum class AttributeTransfer
+{
+	//! A quantity proportional to volume (such as an amount): a refined tile
+	//! distributes its value over its children by volume, and merged tiles
+	//! add their values
+	extensive,
+	//! A quantity per unit volume (such as a concentration): a refined tile
+	//! passes its value to its children, and merged tiles take their mean
+	//! weighted by volume
+	intensive
+};
+
+namespace detail
+{
+/*!
+ * @brief Get the given component of an element of a per-tile view of rank 1
+ * (with a single component) or rank 2
+ */
+template <typename TView>
+KOKKOS_INLINE_FUNCTION
+typename TView::reference_type
+getTileComponent(const TView& view, IdType tileId, std::size_t k)
+{
+	if constexpr (TView::rank == 1) {
+		return view(tileId);
+	}
+	else {
+		return view(tileId, k);
+	}
+}
+
+/*!
+ * @brief Allocate a per-tile view of rank 1 or 2, zero-initialized
+ */
+template <typename TView>
+TView
+makeTileView(const std::string& label, IdType numTiles,
+	[[maybe_unused]] std::size_t numComponents)
+{
+	if constexpr (TView::rank == 1) {
+		return TView(label, numTiles);
+	}
+	else {
+		return TView(label, numTiles, numComponents);
+	}
+}
+
+/*!
+ * @brief Per-tile data stored as a view of rank 1, or of rank 2 for several
+ * components per tile
+ */
+template <typename TDataType, typename TMemSpace>
+class TileAttributeColumn
+{
+public:
+	using DataType = TDataType;
+	using MemorySpace = TMemSpace;
+	using ViewType = Kokkos::View<TDataType, MemorySpace>;
+	using ValueType = typename ViewType::non_const_value_type;
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+	using VolumesView = Kokkos::View<double*, MemorySpace>;
+	using HostMirrorSpace = typename IdsView::traits::host_mirror_space;
+
+	static_assert(ViewType::rank == 1 || ViewType::rank == 2,
+		"Tile attributes have one or two dimensions");
+	static_assert(std::is_arithmetic_v<ValueType>,
+		"Tile attributes have arithmetic values");
+
+	TileAttributeColumn(const ViewType& view, AttributeTransfer transfer) :
+		_view(view), _transfer(transfer)
+	{
+	}
+
+	std::string
+	getName() const
+	{
+		return _view.label();
+	}
+
+	const ViewType&
+	getView() const noexcept
+	{
+		return _view;
+	}
+
+	/*!
+	 * @brief Get size (in bytes) of memory used
+	 */
+	std::uint64_t
+	getDeviceMemorySize() const noexcept
+	{
+		return _view.required_allocation_size(
+			_view.extent(0), ViewType::rank == 2 ? _view.extent(1) : 0);
+	}
+
+	/*!
+	 * @brief Replace the data with zeros for the given number of tiles
+	 */
+	void
+	reset(IdType numTiles)
+	{
+		_view = makeTileView<ViewType>(
+			_view.label(), numTiles, getNumComponents());
+	}
+
+	/*!
+	 * @brief Replace the data with that for the tiles after refinement
+	 */
+	void
+	prolongate(const Prolongation<MemorySpace>& prolongation)
+	{
+		auto numComponents = getNumComponents();
+		auto newView = makeTileView<ViewType>(
+			_view.label(), prolongation.getNumberOfTiles(), numComponents);
+		auto view = _view;
+		auto parentTileIds = prolongation.getParentTileIds();
+		auto weights = prolongation.getWeights();
+		bool extensive = _transfer == AttributeTransfer::extensive;
+		Kokkos::parallel_for(
+			"ProlongateTileAttribute", prolongation.getNumberOfTiles(),
+			KOKKOS_LAMBDA(IdType i) {
+				auto parentId = parentTileIds(i);
+				auto weight = extensive ? weights(i) : 1.0;
+				for (std::size_t k = 0; k < numComponents; ++k) {
+					auto value = static_cast<double>(
+						getTileComponent(view, parentId, k));
+					getTileComponent(newView, i, k) =
+						static_cast<ValueType>(weight * value);
+				}
+			});
+		Kokkos::fence();
+		_view = newView;
+	}
+
+	/*!
+	 * @brief Reorder the data by newData(i) = oldData(order(i))
+	 */
+	void
+	permute(const IdsView& order)
+	{
+		auto numComponents = getNumComponents();
+		auto numTiles = static_cast<IdType>(order.size());
+		auto newView =
+			makeTileView<ViewType>(_view.label(), numTiles, numComponents);
+		auto view = _view;
+		Kokkos::parallel_for(
+			"PermuteTileAttribute", numTiles, KOKKOS_LAMBDA(IdType i) {
+				for (std::size_t k = 0; k < numComponents; ++k) {
+					getTileComponent(newView, i, k) =
+						getTileComponent(view, order(i), k);
+				}
+			});
+		Kokkos::fence();
+		_view = newView;
+	}
+
+	/*!
+	 * @brief Replace the data with that for the tiles after merging, given
+	 * the map from old to new tile ids and the volumes of the old and new
+	 * tiles
+	 */
+	void
+	merge(const IdsView& tileMap, const VolumesView& oldVolumes,
+		const VolumesView& newVolumes)
+	{
+		auto numComponents = getNumComponents();
+		auto newView = makeTileView<ViewType>(_view.label(),
+			static_cast<IdType>(newVolumes.size()), numComponents);
+		auto view = _view;
+		bool extensive = _transfer == AttributeTransfer::extensive;
+		Kokkos::parallel_for(
+			"MergeTileAttribute", static_cast<IdType>(tileMap.size()),
+			KOKKOS_LAMBDA(IdType i) {
+				auto newId = tileMap(i);
+				auto weight =
+					extensive ? 1.0 : oldVolumes(i) / newVolumes(newId);
+				for (std::size_t k = 0; k < numComponents; ++k) {
+					auto value =
+						static_cast<double>(getTileComponent(view, i, k));
+					Kokkos::atomic_add(&getTileComponent(newView, newId, k),
+						static_cast<ValueType>(weight * value));
+				}
+			});
+		Kokkos::fence();
+		_view = newView;
+	}
+
+	/*!
+	 * @brief Copy the column to the host
+	 */
+	TileAttributeColumn<TDataType, HostMirrorSpace>
+	makeMirrorCopy() const
+	{
+		using MirrorType = TileAttributeColumn<TDataType, HostMirrorSpace>;
+		auto mirror = makeTileView<typename MirrorType::ViewType>(
+			_view.label(), static_cast<IdType>(_view.extent(0)),
+			getNumComponents());
+		deep_copy(mirror, _view);
+		return MirrorType{mirror, _transfer};
+	}
+
+private:
+	std::size_t
+	getNumComponents() const noexcept
+	{
+		return (ViewType::rank == 2) ? _view.extent(1) : 1;
+	}
+
+	ViewType _view;
+	AttributeTransfer _transfer;
+};
+
+/*!
+ * @brief Lists of the columns of a TileAttributes table, one for each of
+ * the value types (in one or two dimensions) an attribute can have
+ */
+template <typename TMemSpace, typename... TValueTypes>
+struct TileAttributeColumnLists
+{
+	template <typename TDataType>
+	using ListType = std::vector<TileAttributeColumn<TDataType, TMemSpace>>;
+
+	using Type =
+		std::tuple<ListType<TValueTypes*>..., ListType<TValueTypes**>...>;
+
+	template <typename TDataType>
+	static constexpr bool contains =
+		(std::is_same_v<TDataType, TValueTypes*> || ...) ||
+		(std::is_same_v<TDataType, TValueTypes**> || ...);
+};
+
+template <typename TMemSpace>
+using TileAttributeColumnListsType = TileAttributeColumnLists<TMemSpace,
+	double, float, std::int32_t, std::int64_t, std::uint32_t, std::uint64_t>;
+} // namespace detail
+
+/*!
+ * @brief TileAttributes holds named attribute columns for the tiles of a
+ * Subpaving, each in a separate view
+ *
+ * The table is kept apart from the Subpaving, so that the Subpaving stays
+ * cheap to copy into kernels, which capture the column views instead. Once
+ * registered with Subpaving::setTileAttributes(), every change to the tiles
+ * replaces each column with one in step with the new tiles. Columns added
+ * after that are sized for the current tiles.
+ *
+ * A column holds double, float, or 32- or 64-bit (signed or unsigned)
+ * integer values, one per tile (such as double*) or several per tile (such
+ * as double**).
+ *
+ * @test unittest_Subpaving.cpp
+ */
+template <typename TMemSpace = DefaultMemSpace>
+class TileAttributes
+{
+public:
+	using MemorySpace = TMemSpace;
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+	using VolumesView = Kokkos::View<double*, MemorySpace>;
+	using HostMirrorSpace = typename IdsView::traits::host_mirror_space;
+
+	TileAttributes() = default;
+
+	/*!
+	 * @brief Construct an empty table for the given number of tiles
+	 */
+	explicit TileAttributes(IdType numTiles) : _numTiles(numTiles)
+	{
+	}
+
+	/*!
+	 * @brief Get the number of tiles the columns are sized for
+	 */
+	IdType
+	getNumberOfTiles() const noexcept
+	{
+		return _numTiles;
+	}
+
+	/*!
+	 * @brief Add a (zero-initialized) column with the given name
+	 *
+	 * The column has one element per tile, or one row of numComponents
+	 * elements per tile if TDataType has two dimensions (such as double**).
+	 * When the tiles change, it is carried over as given by transfer.
+	 *
+	 * @return The view for the column
+	 */
+	template <typename TDataType>
+	Kokkos::View<TDataType, MemorySpace>
+	add(const std::string& name,
+		AttributeTransfer transfer = AttributeTransfer::extensive,
+		std::size_t numComponents = 1)
+	{
+		using ColumnType = detail::TileAttributeColumn<TDataType, MemorySpace>;
+		if (contains(name)) {
+			throw std::invalid_argument(
+				"Subpaving: tile attribute '" + name + "' already exists");
+		}
+		auto view = detail::makeTileView<typename ColumnType::ViewType>(
+			name, _numTiles, numComponents);
+		getColumns<TDataType>().push_back(ColumnType{view, transfer});
+		return view;
+	}
+
+	/*!
+	 * @brief Get the current view of the column with the given name, which
+	 * must have the given data type
+	 */
+	template <typename TDataType>
+	Kokkos::View<TDataType, MemorySpace>
+	get(const std::string& name) const
+	{
+		for (const auto& column : getColumns<TDataType>()) {
+			if (column.getName() == name) {
+				return column.getView();
+			}
+		}
+		if (contains(name)) {
+			throw std::invalid_argument("Subpaving: tile attribute '" + name +
+				"' has a different data type");
+		}
+		throw std::invalid_argument(
+			"Subpaving: no tile attribute '" + name + "'");
+	}
+
+	/*!
+	 * @brief Check whether there is a column with the given name
+	 */
+	bool
+	contains(const std::string& name) const
+	{
+		bool ret = false;
+		forEachColumn(*this, [&](const auto& column) {
+			ret = ret || column.getName() == name;
+		});
+		return ret;
+	}
+
+	/*!
+	 * @brief Remove the column with the given name (if there is one)
+	 */
+	void
+	remove(const std::string& name)
+	{
+		std::apply(
+			[&name](auto&... lists) {
+				auto removeFrom = [&name](auto& list) {
+					list.erase(std::remove_if(list.begin(), list.end(),
+								   [&name](const auto& column) {
+									   return column.getName() == name;
+								   }),
+						list.end());
+				};
+				(removeFrom(lists), ...);
+			},
+			_columns);
+	}
+
+	bool
+	empty() const noexcept
+	{
+		return std::apply(
+			[](const auto&... lists) { return (lists.empty() && ...); },
+			_columns);
+	}
+
+	/*!
+	 * @brief Get the names of the columns (in sorted order)
+	 */
+	std::vector<std::string>
+	getNames() const
+	{
+		std::vector<std::string> ret;
+		forEachColumn(*this,
+			[&ret](const auto& column) { ret.push_back(column.getName()); });
+		std::sort(ret.begin(), ret.end());
+		return ret;
+	}
+
+	/*!
+	 * @brief Get size (in bytes) of memory used by the columns
+	 */
+	std::uint64_t
+	getDeviceMemorySize() const noexcept
+	{
+		std::uint64_t ret{};
+		forEachColumn(*this, [&ret](const auto& column) {
+			ret += column.getDeviceMemorySize();
+		});
+		return ret;
+	}
+
+	/*!
+	 * @brief Replace the columns with zeros for the given number of tiles
+	 * (see Subpaving::load())
+	 */
+	void
+	reset(IdType numTiles)
+	{
+		forEachColumn(
+			*this, [numTiles](auto& column) { column.reset(numTiles); });
+		_numTiles = numTiles;
+	}
+
+	/*!
+	 * @brief Replace the columns with those for the tiles after refinement
+	 */
+	void
+	prolongate(const Prolongation<MemorySpace>& prolongation)
+	{
+		forEachColumn(*this,
+			[&prolongation](auto& column) { column.prolongate(prolongation); });
+		_numTiles = prolongation.getNumberOfTiles();
+	}
+
+	/*!
+	 * @brief Reorder the columns by newData(i) = oldData(order(i)) (see
+	 * Subpaving::reorderTiles())
+	 */
+	void
+	permute(const IdsView& order)
+	{
+		forEachColumn(*this, [&order](auto& column) { column.permute(order); });
+	}
+
+	/*!
+	 * @brief Replace the columns with those for the tiles after merging,
+	 * given the map from old to new tile ids (see Subpaving::coarsen()) and
+	 * the volumes of the old and new tiles
+	 */
+	void
+	merge(const IdsView& tileMap, const VolumesView& oldVolumes,
+		const VolumesView& newVolumes)
+	{
+		forEachColumn(*this, [&](auto& column) {
+			column.merge(tileMap, oldVolumes, newVolumes);
+		});
+		_numTiles = static_cast<IdType>(newVolumes.size());
+	}
+
+	/*!
+	 * @brief Copy the columns to the host
+	 */
+	TileAttributes<HostMirrorSpace>
+	makeMirrorCopy() const
+	{
+		TileAttributes<HostMirrorSpace> ret{_numTiles};
+		forEachColumn(*this, [&ret](const auto& column) {
+			using DataType = typename std::decay_t<decltype(column)>::DataType;
+			ret.template getColumns<DataType>().push_back(
+				column.makeMirrorCopy());
+		});
+		return ret;
+	}
+
+private:
+	template <typename>
+	friend class TileAttributes;
+
+	using ColumnLists = detail::TileAttributeColumnListsType<MemorySpace>;
+
+	template <typename TDataType>
+	using ColumnList = typename ColumnLists::template ListType<TDataType>;
+
+	template <typename TDataType>
+	ColumnList<TDataType>&
+	getColumns() noexcept
+	{
+		static_assert(ColumnLists::template contains<TDataType>,
+			"Tile attributes have double, float, or 32- or 64-bit integer "
+			"values");
+		return std::get<ColumnList<TDataType>>(_columns);
+	}
+
+	template <typename TDataType>
+	const ColumnList<TDataType>&
+	getColumns() const noexcept
+	{
+		static_assert(ColumnLists::template contains<TDataType>,
+			"Tile attributes have double, float, or 32- or 64-bit integer "
+			"values");
+		return std::get<ColumnList<TDataType>>(_columns);
+	}
+
+	/*!
+	 * @brief Apply the given function to each column of the given table
+	 * (const or not)
+	 */
+	template <typename TTable, typename TFunction>
+	static void
+	forEachColumn(TTable& table, const TFunction& func)
+	{
+		std::apply(
+			[&func](auto&... lists) {
+				auto visit = [&func](auto& list) {
+					for (auto& column : list) {
+						func(column);
+					}
+				};
+				(visit(lists), ...);
+			},
+			table._columns);
+	}
+
+	//! Number of tiles the columns are sized for
+	IdType _numTiles{};
+	//! Columns, in a list for each data type
+	typename ColumnLists::Type _columns;
+};
+} // namespace plsm
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
+
 #include <plsm/IntervalRange.h>
 #include <plsm/Region.h>
 #include <plsm/Tile.h>
@@ -14,6 +17,20 @@ namespace plsm
  * Zones in a hierarchical subdivision by means of indices (for parent and
  * children) and potentially an owning relationship with a Tile.
  *
+ * If PLSM_USE_IMPLICIT_ZONE_REGIONS is defined, the Zone does not store its
+ * Region. Instead it stores its (local) index among the candidate sub-zones
+ * of its parent and, once refined, the axes along which it was subdivided;
+ * the Region is reconstructed from those (see Subpaving::getZoneRegion()).
+ *
+ * If PLSM_USE_PACKED_ZONES is defined, the level is stored in 8 bits, and a
+ * single index serves as either the first subzone or the owned Tile (a Zone
+ * never has both), with a 16-bit subzone count and a flag bit for the Tile.
+ * This limits the depth of refinement (see maxLevel) and the subdivision
+ * ratio product of each level (see maxNumSubZones).
+ *
+ * If PLSM_USE_SOA_ZONES is defined, a Subpaving does not store Zones but
+ * keeps each of their fields in a separate view (see detail::ZoneColumns).
+ *
  * @tparam TRegion Type used for lattice region
  *
  * @test test_Zone.cpp
@@ -25,21 +42,54 @@ public:
 	//! Alias for Region
 	using RegionType = TRegion;
 
+#if defined(PLSM_USE_PACKED_ZONES)
+	//! Type used to store the subdivision level
+	using LevelType = std::uint8_t;
+	//! Type used to store the number of subzones
+	using NumSubZonesType = std::uint16_t;
+#else
+	//! Type used to store the subdivision level
+	using LevelType = std::size_t;
+	//! Type used to store the number of subzones
+	using NumSubZonesType = IdType;
+#endif
+
+	//! Largest subdivision level a Zone can have
+	static constexpr std::size_t maxLevel =
+		std::numeric_limits<LevelType>::max();
+	//! Largest number of subzones a Zone can have
+	static constexpr std::size_t maxNumSubZones =
+		std::numeric_limits<NumSubZonesType>::max();
+
 	/*!
 	 * @brief Default construct with empty Region, no parent, no children, and
 	 * no Tile at level 0
 	 */
 	Zone() = default;
 
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	/*!
+	 * @brief Construct with local index (among the candidate sub-zones of the
+	 * parent), subdivision level, and index of parent Zone
+	 */
+	KOKKOS_INLINE_FUNCTION
+	Zone(IdType localId, std::size_t level, IdType parentId = invalid<IdType>) :
+		_parentId{parentId}, _localId{localId}
+	{
+		_level = static_cast<LevelType>(level);
+	}
+#else
 	/*!
 	 * @brief Construct with Region, subdivision level, and index or parent Zone
 	 */
 	KOKKOS_INLINE_FUNCTION
 	Zone(const RegionType& region, std::size_t level,
 		IdType parentId = invalid<IdType>) :
-		_region{region}, _level{level}, _parentId{parentId}
+		_region{region}, _parentId{parentId}
 	{
+		_level = static_cast<LevelType>(level);
 	}
+#endif
 
 	/*!
 	 * @brief Dimension of lattice
@@ -58,7 +108,11 @@ public:
 	bool
 	hasTile() const noexcept
 	{
+#if defined(PLSM_USE_PACKED_ZONES)
+		return (_flags & tileFlag) != 0;
+#else
 		return (_tileId != invalid<IdType>);
+#endif
 	}
 
 	/*!
@@ -68,7 +122,11 @@ public:
 	IdType
 	getTileIndex() const noexcept
 	{
+#if defined(PLSM_USE_PACKED_ZONES)
+		return hasTile() ? _index : invalid<IdType>;
+#else
 		return _tileId;
+#endif
 	}
 
 	/*!
@@ -78,7 +136,17 @@ public:
 	void
 	setTileIndex(IdType tileId) noexcept
 	{
+#if defined(PLSM_USE_PACKED_ZONES)
+		if (tileId == invalid<IdType>) {
+			removeTile();
+			return;
+		}
+		_index = tileId;
+		_numSubZones = 0;
+		_flags |= tileFlag;
+#else
 		_tileId = tileId;
+#endif
 	}
 
 	/*!
@@ -88,7 +156,14 @@ public:
 	void
 	removeTile() noexcept
 	{
+#if defined(PLSM_USE_PACKED_ZONES)
+		if (hasTile()) {
+			_index = 0;
+			_flags &= static_cast<std::uint8_t>(~tileFlag);
+		}
+#else
 		_tileId = invalid<IdType>;
+#endif
 	}
 
 	/*!
@@ -105,20 +180,38 @@ public:
 	 * @brief Get Interval of indices to subzones
 	 */
 	KOKKOS_INLINE_FUNCTION
-	const Interval<IdType>&
+	Interval<IdType>
 	getSubZoneIndices() const noexcept
 	{
+#if defined(PLSM_USE_PACKED_ZONES)
+		if (hasTile()) {
+			return {};
+		}
+		return {_index, _index + _numSubZones};
+#else
 		return _subZoneIds;
+#endif
 	}
 
 	/*!
 	 * @brief Set Interval of indices to subzones
+	 *
+	 * With PLSM_USE_PACKED_ZONES, setting a non-empty Interval disowns any
+	 * Tile, and the Interval must not be longer than maxNumSubZones.
 	 */
 	KOKKOS_INLINE_FUNCTION
 	void
 	setSubZoneIndices(const Interval<IdType>& subZoneIds)
 	{
+#if defined(PLSM_USE_PACKED_ZONES)
+		_numSubZones = static_cast<NumSubZonesType>(subZoneIds.length());
+		if (!subZoneIds.empty()) {
+			removeTile();
+			_index = subZoneIds.begin();
+		}
+#else
 		_subZoneIds = subZoneIds;
+#endif
 	}
 
 	/*!
@@ -128,9 +221,50 @@ public:
 	IntervalRange<IdType>
 	getSubZoneRange() const noexcept
 	{
-		return IntervalRange<IdType>{_subZoneIds};
+		return IntervalRange<IdType>{getSubZoneIndices()};
 	}
 
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	/*!
+	 * @brief Get the index of the Zone among the candidate sub-zones of its
+	 * parent (its linear index in the grid they form)
+	 */
+	KOKKOS_INLINE_FUNCTION
+	IdType
+	getLocalIndex() const noexcept
+	{
+		return _localId;
+	}
+
+	/*!
+	 * @brief Get the axes along which the Zone was subdivided (bit i set for
+	 * axis i)
+	 */
+	KOKKOS_INLINE_FUNCTION
+	std::uint8_t
+	getSubZoneAxes() const noexcept
+	{
+#if defined(PLSM_USE_PACKED_ZONES)
+		return static_cast<std::uint8_t>(_flags >> 1);
+#else
+		return _subZoneAxes;
+#endif
+	}
+
+	/*!
+	 * @brief Set the axes along which the Zone was subdivided
+	 */
+	KOKKOS_INLINE_FUNCTION
+	void
+	setSubZoneAxes(std::uint8_t axes) noexcept
+	{
+#if defined(PLSM_USE_PACKED_ZONES)
+		_flags = static_cast<std::uint8_t>((_flags & tileFlag) | (axes << 1));
+#else
+		_subZoneAxes = axes;
+#endif
+	}
+#else
 	/*!
 	 * @brief Get the Zone's Region
 	 */
@@ -140,6 +274,7 @@ public:
 	{
 		return _region;
 	}
+#endif
 
 	/*!
 	 * @brief Check if the Zone has a valid index to a parent Zone
@@ -161,16 +296,66 @@ public:
 		return _parentId;
 	}
 
+	/*!
+	 * @brief Set the index to the parent Zone
+	 */
+	KOKKOS_INLINE_FUNCTION
+	void
+	setParentIndex(IdType parentId) noexcept
+	{
+		_parentId = parentId;
+	}
+
 private:
+#if defined(PLSM_USE_PACKED_ZONES)
+	//! Bit of _flags set if the Zone owns a Tile
+	static constexpr std::uint8_t tileFlag = 1;
+#endif
+
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+#if defined(PLSM_USE_PACKED_ZONES)
+	static_assert(RegionType::dimension() <= 7,
+		"The sub-zone axes of a zone are stored in 7 bits of its flags");
+#else
+	static_assert(RegionType::dimension() <= 8,
+		"The sub-zone axes of a zone are stored in 8 bits");
+#endif
+#else
 	//! Referenced Region
 	RegionType _region;
+#endif
+#if defined(PLSM_USE_PACKED_ZONES)
+	//! Index to parent Zone
+	IdType _parentId{invalid<IdType>};
+	//! Index to the first subzone, or to the owned Tile if the tile flag is
+	//! set
+	IdType _index{};
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	//! Index among the candidate sub-zones of the parent
+	IdType _localId{};
+#endif
+	//! Number of subzones
+	NumSubZonesType _numSubZones{};
+	//! Subdivision level
+	LevelType _level{};
+	//! The tile flag, followed by the axes along which the sub-zones
+	//! subdivide this Zone (with PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	std::uint8_t _flags{};
+#else
 	//! Subdivision level
-	std::size_t _level{};
+	LevelType _level{};
 	//! Index to parent Zone
 	IdType _parentId{invalid<IdType>};
 	//! Interval of indices to subzones
 	Interval<IdType> _subZoneIds;
 	//! Index to owned Tile
 	IdType _tileId{invalid<IdType>};
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	//! Index among the candidate sub-zones of the parent
+	IdType _localId{};
+	//! Axes along which the sub-zones subdivide this Zone
+	std::uint8_t _subZoneAxes{};
+#endif
+#endif
 };
 } // namespace plsm
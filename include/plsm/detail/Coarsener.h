@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Kokkos_Bitset.hpp>
+
+#include <plsm/Utility.h>
+#include <plsm/refine/Detector.h>
+
+namespace plsm
+{
+namespace detail
+{
+/*!
+ * @brief Coarsener merges sibling tiles back into their parent zone wherever
+ * the refine::Detector no longer calls for refinement, and then compacts the
+ * Subpaving zones and tiles
+ */
+template <typename TSubpaving, typename TDetector>
+class Coarsener
+{
+public:
+	using SubpavingType = TSubpaving;
+	using ZoneType = typename SubpavingType::ZoneType;
+	using TileType = typename SubpavingType::TileType;
+	using ZonesView = typename SubpavingType::ZonesView;
+	using TilesView = typename SubpavingType::TilesView;
+	using ItemDataView = typename SubpavingType::ItemDataView;
+	using MemorySpace = typename SubpavingType::MemorySpace;
+	using IdsView = Kokkos::View<IdType*, MemorySpace>;
+	using DetectorType = TDetector;
+
+	/*!
+	 * @brief Coarsen until no more zones can be merged
+	 * @return Map from old to new tile ids (tiles which were merged map to
+	 * the tile they were merged into)
+	 */
+	IdsView
+	operator()();
+
+	/*!
+	 * @brief Find each zone whose sub-zones are all tiles and which the
+	 * detector would no longer refine
+	 * @return Number of zones found
+	 */
+	IdType
+	findMergeableZones();
+
+	/*!
+	 * @brief Replace the sub-zones of each mergeable zone with a single tile
+	 */
+	void
+	mergeZones();
+
+	/*!
+	 * @brief Remove the merged zones and tiles (and the item data of the
+	 * merged tiles)
+	 * @return Map from old to new tile ids
+	 */
+	IdsView
+	compact();
+
+protected:
+	template <typename, DimType, typename, typename, typename>
+	friend class ::plsm::Subpaving;
+
+	Coarsener(SubpavingType& subpaving, const DetectorType& detector);
+
+protected:
+	SubpavingType& _subpaving;
+	DetectorType _detector;
+	std::size_t _targetDepth;
+
+	ZonesView _zones;
+	TilesView _tiles;
+
+	//! Zones to be merged at the current iteration
+	Kokkos::Bitset<DefaultExecSpace> _mergeableZones;
+	//! Zones and tiles which have been merged away
+	Kokkos::Bitset<DefaultExecSpace> _deadZones;
+	Kokkos::Bitset<DefaultExecSpace> _deadTiles;
+	//! For each tile, the tile it was merged into (or itself)
+	IdsView _mergedTileIds;
+	IdType _numMerged{};
+};
+} // namespace detail
+} // namespace plsm
+
+#include <plsm/detail/Coarsener.inl>
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <plsm/IntervalRange.h>
+#include <plsm/detail/ZoneRegion.h>
+
+namespace plsm
+{
+namespace detail
+{
+using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
+
+template <typename TSubpaving, typename TDetector>
+Coarsener<TSubpaving, TDetector>::Coarsener(
+	SubpavingType& subpaving, const DetectorType& detector) :
+	_subpaving(subpaving),
+	_detector(detector),
+	_targetDepth((detector.depth() == detector.fullDepth) ?
+			subpaving._subdivisionInfos.size() :
+			detector.depth()),
+	_zones(subpaving._zones),
+	_tiles(subpaving._tiles)
+{
+}
+
+template <typename TSubpaving, typename TDetector>
+typename Coarsener<TSubpaving, TDetector>::IdsView
+Coarsener<TSubpaving, TDetector>::operator()()
+{
+	auto numZones = static_cast<unsigned>(_zones.size());
+	auto numTiles = static_cast<IdType>(_tiles.size());
+	_mergeableZones = Kokkos::Bitset<DefaultExecSpace>(numZones);
+	_deadZones = Kokkos::Bitset<DefaultExecSpace>(numZones);
+	_deadTiles =
+		Kokkos::Bitset<DefaultExecSpace>(static_cast<unsigned>(numTiles));
+	_mergedTileIds = IdsView(AllocNoInit{"Merged Tile Ids"}, numTiles);
+	auto mergedTileIds = _mergedTileIds;
+	Kokkos::parallel_for(
+		"InitializeMergedTileIds", numTiles,
+		KOKKOS_LAMBDA(IdType i) { mergedTileIds(i) = i; });
+	Kokkos::fence();
+
+	// Each pass can expose parents whose sub-zones have all become tiles
+	while (findMergeableZones() > 0) {
+		mergeZones();
+	}
+
+	return compact();
+}
+
+template <typename TSubpaving, typename TDetector>
+IdType
+Coarsener<TSubpaving, TDetector>::findMergeableZones()
+{
+	using RegionType = typename ZoneType::RegionType;
+	using BoolVec = refine::BoolVec<RegionType>;
+
+	_mergeableZones.reset();
+	auto zones = _zones;
+	auto infos = _subpaving._subdivisionInfos;
+	auto rootRegion = _subpaving._rootRegion;
+	auto mergeableZones = _mergeableZones;
+	auto deadZones = _deadZones;
+	auto detector = _detector;
+	auto targetDepth = _targetDepth;
+	IdType count = 0;
+	Kokkos::parallel_reduce(
+		"FindMergeableZones", static_cast<IdType>(zones.size()),
+		KOKKOS_LAMBDA(IdType i, IdType & running) {
+			const auto& zone = zones(i);
+			if (zone.hasTile() || deadZones.test(static_cast<unsigned>(i)) ||
+				zone.getSubZoneIndices().empty()) {
+				return;
+			}
+			for (auto j : zone.getSubZoneRange()) {
+				if (!zones(j).hasTile()) {
+					return;
+				}
+			}
+			if (zone.getLevel() < targetDepth) {
+				bool keepRefined = false;
+				auto region = getZoneRegion(zones, infos, rootRegion, i);
+				auto classification = detector.classify(region);
+				if (!refine::detail::getImpliedDecision(
+						detector.refineTag, classification, keepRefined)) {
+					BoolVec enable{};
+					keepRefined =
+						detector(detector.refineTag, region, enable);
+				}
+				if (keepRefined) {
+					return;
+				}
+			}
+			mergeableZones.set(static_cast<unsigned>(i));
+			++running;
+		},
+		count);
+	Kokkos::fence();
+	return count;
+}
+
+template <typename TSubpaving, typename TDetector>
+void
+Coarsener<TSubpaving, TDetector>::mergeZones()
+{
+	auto zones = _zones;
+	auto tiles = _tiles;
+	auto infos = _subpaving._subdivisionInfos;
+	auto rootRegion = _subpaving._rootRegion;
+	auto mergeableZones = _mergeableZones;
+	auto deadZones = _deadZones;
+	auto deadTiles = _deadTiles;
+	auto mergedTileIds = _mergedTileIds;
+	Kokkos::parallel_for(
+		"MergeZones", static_cast<IdType>(zones.size()),
+		KOKKOS_LAMBDA(IdType i) {
+			if (!mergeableZones.test(static_cast<unsigned>(i))) {
+				return;
+			}
+			// The first sub-zone's tile is reused for the merged zone
+			auto&& zone = zones(i);
+			auto subZones = zone.getSubZoneRange();
+			auto tileId = zones(*subZones.begin()).getTileIndex();
+			for (auto j : subZones) {
+				deadZones.set(static_cast<unsigned>(j));
+				auto subTileId = zones(j).getTileIndex();
+				if (subTileId != tileId) {
+					deadTiles.set(static_cast<unsigned>(subTileId));
+					mergedTileIds(subTileId) = tileId;
+				}
+			}
+			tiles(tileId) =
+				TileType{getZoneRegion(zones, infos, rootRegion, i), i};
+			zone.setTileIndex(tileId);
+			zone.setSubZoneIndices({});
+		});
+	Kokkos::fence();
+}
+
+template <typename TSubpaving, typename TDetector>
+typename Coarsener<TSubpaving, TDetector>::IdsView
+Coarsener<TSubpaving, TDetector>::compact()
+{
+	auto numZones = static_cast<IdType>(_zones.size());
+	auto numTiles = static_cast<IdType>(_tiles.size());
+	auto deadZones = _deadZones;
+	auto deadTiles = _deadTiles;
+
+	// Find new positions for the remaining zones and tiles
+	auto newZoneIds = IdsView(AllocNoInit{"New Zone Ids"}, numZones);
+	IdType numNewZones = 0;
+	Kokkos::parallel_scan(
+		"ScanNewZoneIds", numZones,
+		KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+			if (finalPass) {
+				newZoneIds(i) = update;
+			}
+			if (!deadZones.test(static_cast<unsigned>(i))) {
+				++update;
+			}
+		},
+		numNewZones);
+	auto newTileIds = IdsView(AllocNoInit{"New Tile Ids"}, numTiles);
+	IdType numNewTiles = 0;
+	Kokkos::parallel_scan(
+		"ScanNewTileIds", numTiles,
+		KOKKOS_LAMBDA(IdType i, IdType & update, const bool finalPass) {
+			if (finalPass) {
+				newTileIds(i) = update;
+			}
+			if (!deadTiles.test(static_cast<unsigned>(i))) {
+				++update;
+			}
+		},
+		numNewTiles);
+	Kokkos::fence();
+
+	// Move the remaining zones and tiles, updating their cross-references
+	auto zones = _zones;
+	auto newZones = ZonesView(AllocNoInit{"zones"}, numNewZones);
+	Kokkos::parallel_for(
+		"CompactZones", numZones, KOKKOS_LAMBDA(IdType i) {
+			if (deadZones.test(static_cast<unsigned>(i))) {
+				return;
+			}
+			const auto& zone = zones(i);
+			ZoneType newZone = zone;
+			if (zone.hasParent()) {
+				newZone.setParentIndex(newZoneIds(zone.getParentIndex()));
+			}
+			const auto& subZoneIds = zone.getSubZoneIndices();
+			if (!subZoneIds.empty()) {
+				auto subZoneBegin = newZoneIds(subZoneIds.begin());
+				newZone.setSubZoneIndices(
+					{subZoneBegin, subZoneBegin + subZoneIds.length()});
+			}
+			if (zone.hasTile()) {
+				newZone.setTileIndex(newTileIds(zone.getTileIndex()));
+			}
+			newZones(newZoneIds(i)) = newZone;
+		});
+	auto tiles = _tiles;
+	auto itemData = _subpaving._itemData;
+	auto newTiles = TilesView(AllocNoInit{"tiles"}, numNewTiles);
+	auto newItemData = ItemDataView(AllocNoInit{"item data"}, numNewTiles);
+	Kokkos::parallel_for(
+		"CompactTiles", numTiles, KOKKOS_LAMBDA(IdType i) {
+			if (deadTiles.test(static_cast<unsigned>(i))) {
+				return;
+			}
+			auto tile = tiles(i);
+			tile.setOwningZoneIndex(newZoneIds(tile.getOwningZoneIndex()));
+			newTiles(newTileIds(i)) = tile;
+			newItemData(newTileIds(i)) = itemData(i);
+		});
+
+	// Follow each merged tile to the tile which finally absorbed it
+	auto mergedTileIds = _mergedTileIds;
+	auto tileMap = IdsView(AllocNoInit{"Tile Map"}, numTiles);
+	Kokkos::parallel_for(
+		"MapTileIds", numTiles, KOKKOS_LAMBDA(IdType i) {
+			auto tileId = i;
+			while (mergedTileIds(tileId) != tileId) {
+				tileId = mergedTileIds(tileId);
+			}
+			tileMap(i) = newTileIds(tileId);
+		});
+
+	std::size_t depth = 0;
+	Kokkos::parallel_reduce(
+		"FindRefinementDepth", numNewZones,
+		KOKKOS_LAMBDA(IdType i, std::size_t & running) {
+			auto level = newZones(i).getLevel();
+			running = (level > running) ? level : running;
+		},
+		Kokkos::Max<std::size_t>(depth));
+	Kokkos::fence();
+
+	_subpaving.setZones(newZones);
+	_subpaving.setTiles(newTiles);
+	_subpaving.setItemData(newItemData);
+	_subpaving.setRefinementDepth(depth);
+
+	return tileMap;
+}
+} // namespace detail
+} // namespace plsm
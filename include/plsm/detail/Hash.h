@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <Kokkos_Macros.hpp>
+
+namespace plsm
+{
+namespace detail
+{
+//! Initial value for hashes (the 64-bit FNV-1a offset basis)
+inline constexpr std::uint64_t hashSeed = 0xcbf29ce484222325ull;
+
+/*!
+ * @brief Mix the given bytes into the given hash (64-bit FNV-1a)
+ *
+ * Unlike std::hash, the result is the same for every run and every build
+ * (on machines with the same byte order), so it can identify stored data.
+ */
+KOKKOS_INLINE_FUNCTION
+std::uint64_t
+hashBytes(std::uint64_t hash, const void* data, std::size_t size) noexcept
+{
+	constexpr std::uint64_t prime = 0x100000001b3ull;
+	auto bytes = static_cast<const unsigned char*>(data);
+	for (std::size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= prime;
+	}
+	return hash;
+}
+
+/*!
+ * @brief Mix the given arithmetic value into the given hash
+ */
+template <typename T>
+KOKKOS_INLINE_FUNCTION
+std::uint64_t
+hashCombine(std::uint64_t hash, const T& value) noexcept
+{
+	static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>,
+		"Combine values member by member, since padding bytes are not "
+		"stable");
+	return hashBytes(hash, &value, sizeof(value));
+}
+
+/*!
+ * @brief Mix the characters of the given string into the given hash
+ */
+inline std::uint64_t
+hashCombine(std::uint64_t hash, const char* str) noexcept
+{
+	return hashBytes(hash, str, std::strlen(str) + 1);
+}
+} // namespace detail
+} // namespace plsm
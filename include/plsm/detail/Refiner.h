@@ -1,14 +1,18 @@
 #pragma once
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
 #include <Kokkos_Bitset.hpp>
 
+#include <plsm/RefinementReport.h>
+#include <plsm/RefinementWorkspace.h>
 #include <plsm/SpaceVector.h>
 #include <plsm/Subpaving.h>
 #include <plsm/Utility.h>
 #include <plsm/detail/SubdivisionInfo.h>
+#include <plsm/refine/Detector.h>
 
 namespace plsm
 {
@@ -29,6 +33,35 @@ struct ItemTotals
 	}
 };
 
+/*!
+ * @brief Team scratch view holding whether each candidate sub-zone of a tile
+ * is selected
+ */
+template <typename TScratchSpace>
+using SelectionFlagsView =
+	Kokkos::View<bool*, TScratchSpace, Kokkos::MemoryUnmanaged>;
+
+/*!
+ * @brief Totals gathered while counting the new items for a level
+ */
+struct CountTotals
+{
+	ItemTotals items{};
+	IdType refineCalls{0};
+	IdType selectCalls{0};
+
+	KOKKOS_INLINE_FUNCTION
+	volatile CountTotals&
+	operator+=(const volatile CountTotals& other) volatile
+	{
+		items.zones += other.items.zones;
+		items.tiles += other.items.tiles;
+		refineCalls += other.refineCalls;
+		selectCalls += other.selectCalls;
+		return *this;
+	}
+};
+
 template <typename TSubpaving, typename TDetector>
 struct RefinerData
 {
@@ -37,9 +70,11 @@ struct RefinerData
 	using SubpavingType = TSubpaving;
 	using ZoneType = typename SubpavingType::ZoneType;
 	using TileType = typename SubpavingType::TileType;
+	using RegionType = typename SubpavingType::RegionType;
 	using ZonesView = typename SubpavingType::ZonesView;
 	using ZonesRAView = typename SubpavingType::ZonesRAView;
 	using TilesView = typename SubpavingType::TilesView;
+	using ItemDataView = typename SubpavingType::ItemDataView;
 
 	static constexpr DimType subpavingDim = SubpavingType::dimension();
 
@@ -50,8 +85,14 @@ struct RefinerData
 	ZonesView zones;
 	ZonesRAView zonesRA;
 	TilesView tiles;
+	ItemDataView itemData;
 
 	Kokkos::View<SubdivisionInfoType*> subdivisionInfos;
+	//! Region of the root zone (from which implicit zone regions are
+	//! reconstructed)
+	RegionType rootRegion;
+	//! How the item data of new tiles is initialized
+	ItemDataInit itemDataInit;
 
 	DetectorType detector;
 
@@ -61,15 +102,33 @@ struct RefinerData
 	Kokkos::Array<Kokkos::Bitset<DefaultExecSpace>, subpavingDim>
 		enableRefine{};
 
-	Kokkos::View<IdType**> selectedSubZones{};
+	//! Selected candidate sub-zones of each active tile (one bit per local
+	//! id), kept from counting to filling when the team is not used
+	Kokkos::View<SelectionMask*> selectionMasks{};
+
+	//! Local ids of the selected sub-zones for each active tile, stored
+	//! contiguously (beginning at subZoneStarts) for those being refined
+	Kokkos::View<IdType*> selectedSubZones{};
 
 	Kokkos::View<IdType*> newZoneCounts{};
 	Kokkos::View<IdType*> subZoneStarts{};
 	Kokkos::View<IdType*> newTileStarts{};
 
+	//! Tiles which may still be refined (the frontier) for the current level
+	Kokkos::View<IdType*> activeTiles{};
+	//! Tiles created or refined during the current level
+	Kokkos::View<IdType*> nextActiveTiles{};
+
+	//! Classification (by the detector) of each active tile; definite
+	//! classifications are inherited by the tiles produced from it
+	Kokkos::View<refine::Classification*> classifications{};
+	//! Classifications corresponding to nextActiveTiles
+	Kokkos::View<refine::Classification*> nextClassifications{};
+
 	ItemTotals newItemTotals{};
 	IdType numZones{static_cast<IdType>(zones.size())};
 	IdType numTiles{static_cast<IdType>(tiles.size())};
+	IdType numActiveTiles{};
 };
 
 /*!
@@ -93,9 +152,58 @@ public:
 	using SubdivisionRatioType = ::plsm::SubdivisionRatio<subpavingDim>;
 	using SubdivisionInfoType = SubdivisionInfo<subpavingDim>;
 
-	void
+	//! Number of candidate sub-zones per tile (subdivision ratio product)
+	//! from which each tile is given to a team of threads to select its
+	//! sub-zones, rather than to a single thread
+	static constexpr IdType teamSelectionThreshold = 32;
+	static_assert(teamSelectionThreshold <= 8 * sizeof(SelectionMask),
+		"Tiles selected without a team must fit in a SelectionMask");
+
+	/*!
+	 * @brief Refine level by level until no more tiles are refined or the
+	 * target depth is reached
+	 * @return Measurements for each level processed
+	 */
+	RefinementReport
 	operator()();
 
+	/*!
+	 * @brief Refine only the given tiles, by one level (the tiles produced
+	 * are not refined further)
+	 *
+	 * The refinement depth of the Subpaving is left for the caller to
+	 * update.
+	 *
+	 * @return Measurements for the level processed
+	 */
+	RefinementReport
+	operator()(const Kokkos::View<IdType*>& tileIds);
+
+	void
+	initializeActiveTiles();
+
+	/*!
+	 * @brief Make the given tiles the active tiles, and start from the lowest
+	 * level among them
+	 */
+	void
+	initializeActiveTiles(const Kokkos::View<IdType*>& tileIds);
+
+	/*!
+	 * @brief Get the largest subdivision ratio product which the active tiles
+	 * may have at the current level
+	 */
+	IdType
+	getMaxRatioProduct() const;
+
+	/*!
+	 * @brief Decide whether to select sub-zones with a team per tile for the
+	 * current level, based on the largest subdivision ratio product which
+	 * the active tiles may have
+	 */
+	bool
+	useTeamSelection() const;
+
 	void
 	countNewItems();
 
@@ -109,13 +217,36 @@ protected:
 	template <typename, DimType, typename, typename, typename>
 	friend class ::plsm::Subpaving;
 
-	Refiner(SubpavingType& subpaving, const DetectorType& detector);
+	Refiner(SubpavingType& subpaving, const DetectorType& detector,
+		RefinementWorkspace<subpavingDim>& workspace);
+
+	/*!
+	 * @brief Point the level buffers at those of the workspace (after
+	 * growing them as needed)
+	 */
+	void
+	updateWorkspace(IdType numNewZones);
+
+	/*!
+	 * @brief Refine the active tiles level by level, from the current level
+	 * up to (not including) the given level
+	 */
+	void
+	refineLevels(std::size_t endLevel, Kokkos::Timer& timer,
+		RefinementReport& report);
 
 protected:
 	SubpavingType& _subpaving;
+	RefinementWorkspace<subpavingDim>& _workspace;
 	typename Kokkos::View<SubdivisionInfoType*>::HostMirror _subdivInfoMirror;
 
 	RefinerData<TSubpaving, TDetector> _data;
+
+	//! Measurements for the current level
+	RefinementLevelReport _levelReport{};
+	//! Whether sub-zones are selected with a team per tile for the current
+	//! level
+	bool _teamSelection{};
 };
 } // namespace detail
 } // namespace plsm
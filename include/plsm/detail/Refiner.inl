@@ -2,6 +2,7 @@
 
 #include <plsm/MultiIndex.h>
 #include <plsm/Utility.h>
+#include <plsm/detail/ZoneRegion.h>
 #include <plsm/refine/Detector.h>
 
 namespace plsm
@@ -13,150 +14,382 @@ using AllocNoInit = Kokkos::ViewAllocateWithoutInitializing;
 template <typename TData>
 KOKKOS_INLINE_FUNCTION
 SubdivisionRatio<TData::subpavingDim>
-getSubdivisionRatio(const TData& data, std::size_t level, IdType tileIndex)
+getSubdivisionRatio(const TData& data, std::size_t level, IdType activeId)
 {
 	auto ret = data.subdivisionInfos[level].getRatio();
 	for (DimType i = 0; i < data.subpavingDim; ++i) {
-		if (!data.enableRefine[i].test(static_cast<unsigned>(tileIndex))) {
+		if (!data.enableRefine[i].test(static_cast<unsigned>(activeId))) {
 			ret[i] = 1;
 		}
 	}
 	return ret;
 }
 
-template <typename TZone>
+/*!
+ * @brief Get the region of the zone owning the given active tile
+ */
+template <typename TData>
 KOKKOS_INLINE_FUNCTION
-typename TZone::RegionType
-getSubZoneRegion(const TZone& zone, IdType subZoneLocalId,
-	const SubdivisionInfo<TZone::dimension()>& subdivInfo)
+typename TData::RegionType
+getActiveZoneRegion(const TData& data, IdType activeId)
 {
-	using RegionType = typename TZone::RegionType;
-	using ScalarType = typename RegionType::ScalarType;
-	using IntervalType = typename RegionType::IntervalType;
-
-	constexpr auto subpavingDim = TZone::dimension();
-
-	MultiIndex<subpavingDim> mId = subdivInfo.getMultiIndex(subZoneLocalId);
-
-	const auto& zoneRegion = zone.getRegion();
-	RegionType ret;
-	for (auto i : makeIntervalRange(subpavingDim)) {
-		const auto& ival = zoneRegion[i];
-		auto delta = ival.length() / subdivInfo.getRatio()[i];
-		ret[i] =
-			IntervalType{ival.begin() + static_cast<ScalarType>(mId[i] * delta),
-				ival.begin() + static_cast<ScalarType>((mId[i] + 1) * delta)};
-	}
-	return ret;
+	const auto& tile = data.tiles(data.activeTiles(activeId));
+	return getZoneRegion(data.zonesRA, data.subdivisionInfos, data.rootRegion,
+		tile.getOwningZoneIndex());
 }
 
+/*!
+ * @brief Apply the selection to each candidate sub-zone of the given zone,
+ * recording the selected ones in the selection mask of the active tile
+ *
+ * @param[in,out] selectCalls Incremented for each call to the detector
+ * @return Number of selected sub-zones
+ */
 template <typename TData>
 KOKKOS_INLINE_FUNCTION
 IdType
-countSelectSubZones(
-	const TData& data, IdType index, const typename TData::ZoneType& zone)
+countSelectSubZones(const TData& data, IdType activeId,
+	const typename TData::ZoneType& zone,
+	const typename TData::RegionType& zoneRegion, IdType& selectCalls)
 {
 	auto info = SubdivisionInfo<TData::subpavingDim>{
-		getSubdivisionRatio(data, zone.getLevel(), index)};
+		getSubdivisionRatio(data, zone.getLevel(), activeId)};
 	auto numSubRegions = info.getRatio().getProduct();
-	auto selected = Kokkos::subview(data.selectedSubZones, index, Kokkos::ALL);
+
+	// Every sub-zone shares the classification of the zone, which may be
+	// enough to decide the selection for all of them at once
+	bool selectAll = false;
+	if (refine::detail::getImpliedDecision(data.detector.selectTag,
+			data.classifications(activeId), selectAll)) {
+		return selectAll ? static_cast<IdType>(numSubRegions) : 0;
+	}
+
+	SelectionMask mask = 0;
 	IdType count = 0;
 	for (auto i : makeIntervalRange(numSubRegions)) {
-		auto subRegion = getSubZoneRegion(zone, i, info);
+		auto subRegion = getSubZoneRegion(zoneRegion, i, info);
+		++selectCalls;
 		if (data.detector(data.detector.selectTag, subRegion)) {
-			selected(count) = i;
+			mask |= SelectionMask{1} << i;
 			++count;
 		}
 	}
+	data.selectionMasks(activeId) = mask;
 	return count;
 }
 
+/*!
+ * @brief Record the sub-zones selected by countSelectSubZones(), without
+ * calling the detector again
+ */
 template <typename TData>
 KOKKOS_INLINE_FUNCTION
 void
-countNewItemsFromTile(
-	const TData& data, IdType index, ItemTotals& runningTotals)
+fillSelectedSubZones(const TData& data, IdType activeId)
+{
+	if (data.newZoneCounts(activeId) == 0) {
+		return;
+	}
+	const auto& tile = data.tiles(data.activeTiles(activeId));
+	const auto& zone = data.zonesRA(tile.getOwningZoneIndex());
+	auto numSubRegions =
+		getSubdivisionRatio(data, zone.getLevel(), activeId).getProduct();
+	auto selectedBegin = data.subZoneStarts(activeId);
+
+	bool selectAll = false;
+	if (refine::detail::getImpliedDecision(data.detector.selectTag,
+			data.classifications(activeId), selectAll)) {
+		for (auto i : makeIntervalRange(numSubRegions)) {
+			data.selectedSubZones(selectedBegin + i) = i;
+		}
+		return;
+	}
+
+	auto mask = data.selectionMasks(activeId);
+	IdType position = 0;
+	for (auto i : makeIntervalRange(numSubRegions)) {
+		if (mask & (SelectionMask{1} << i)) {
+			data.selectedSubZones(selectedBegin + position) = i;
+			++position;
+		}
+	}
+}
+
+/*!
+ * @brief Decide whether the given active tile is to be refined (recording
+ * along which axes), only calling the detector if the classification of the
+ * tile does not already imply the decision
+ *
+ * @param[in,out] refineCalls Incremented for each call to the detector
+ */
+template <typename TData>
+KOKKOS_INLINE_FUNCTION
+bool
+decideRefinement(const TData& data, IdType activeId,
+	const typename TData::RegionType& zoneRegion, IdType& refineCalls)
 {
-	using RegionType = typename TData::ZoneType::RegionType;
+	using RegionType = typename TData::RegionType;
 	using BoolVec = refine::BoolVec<RegionType>;
-	const auto& tile = data.tiles(index);
-	auto zoneId = tile.getOwningZoneIndex();
-	IdType count = 0;
-	auto& zone = data.zonesRA(zoneId);
-	auto level = zone.getLevel();
-	if (level < data.targetDepth) {
-		BoolVec enable{};
-		if (data.detector(data.detector.refineTag, tile.getRegion(), enable)) {
-			for (DimType i = 0; i < data.subpavingDim; ++i) {
-				if (enable[i]) {
-					data.enableRefine[i].set(static_cast<unsigned>(index));
-				}
-				else {
-					data.enableRefine[i].reset(static_cast<unsigned>(index));
-				}
+	const auto& tile = data.tiles(data.activeTiles(activeId));
+	const auto& zone = data.zonesRA(tile.getOwningZoneIndex());
+	if (zone.getLevel() >= data.targetDepth) {
+		return false;
+	}
+
+	// Only tiles which may cross the boundary need to be (re)classified
+	auto classification = data.classifications(activeId);
+	if (classification == refine::Classification::boundary) {
+		classification = data.detector.classify(zoneRegion);
+		data.classifications(activeId) = classification;
+	}
+	BoolVec enable{};
+	bool shouldRefine = false;
+	if (refine::detail::getImpliedDecision(
+			data.detector.refineTag, classification, shouldRefine)) {
+		data.detector.applyResult(shouldRefine, enable);
+	}
+	else {
+		++refineCalls;
+		shouldRefine =
+			data.detector(data.detector.refineTag, zoneRegion, enable);
+	}
+	if (shouldRefine) {
+		for (DimType i = 0; i < data.subpavingDim; ++i) {
+			if (enable[i]) {
+				data.enableRefine[i].set(static_cast<unsigned>(activeId));
+			}
+			else {
+				data.enableRefine[i].reset(static_cast<unsigned>(activeId));
 			}
-			count = countSelectSubZones(data, index, zone);
 		}
 	}
-	data.newZoneCounts(index) = count;
+	return shouldRefine;
+}
+
+template <typename TData>
+KOKKOS_INLINE_FUNCTION
+void
+recordNewZoneCount(const TData& data, IdType activeId, IdType count,
+	CountTotals& runningTotals)
+{
+	data.newZoneCounts(activeId) = count;
 	if (count > 0) {
-		runningTotals.zones += count;
-		runningTotals.tiles += count - 1;
+		runningTotals.items.zones += count;
+		runningTotals.items.tiles += count - 1;
+	}
+}
+
+template <typename TData>
+KOKKOS_INLINE_FUNCTION
+void
+countNewItemsFromTile(
+	const TData& data, IdType activeId, CountTotals& runningTotals)
+{
+	IdType count = 0;
+	auto zoneRegion = getActiveZoneRegion(data, activeId);
+	if (decideRefinement(
+			data, activeId, zoneRegion, runningTotals.refineCalls)) {
+		const auto& tile = data.tiles(data.activeTiles(activeId));
+		const auto& zone = data.zonesRA(tile.getOwningZoneIndex());
+		count = countSelectSubZones(
+			data, activeId, zone, zoneRegion, runningTotals.selectCalls);
+	}
+	recordNewZoneCount(data, activeId, count, runningTotals);
+}
+
+/*!
+ * @brief Team version of countNewItemsFromTile(), for the active tile given
+ * by the league rank, in which the threads of the team evaluate the
+ * selection of the candidate sub-zones
+ */
+template <typename TData, typename TTeamMember>
+KOKKOS_INLINE_FUNCTION
+void
+countNewItemsFromTileTeam(
+	const TData& data, const TTeamMember& member, CountTotals& runningTotals)
+{
+	auto activeId = static_cast<IdType>(member.league_rank());
+	auto zoneRegion = getActiveZoneRegion(data, activeId);
+	bool shouldRefine = false;
+	Kokkos::single(
+		Kokkos::PerTeam(member),
+		[&](bool& result) {
+			result = decideRefinement(
+				data, activeId, zoneRegion, runningTotals.refineCalls);
+		},
+		shouldRefine);
+
+	IdType count = 0;
+	IdType selectCalls = 0;
+	if (shouldRefine) {
+		const auto& tile = data.tiles(data.activeTiles(activeId));
+		const auto& zone = data.zonesRA(tile.getOwningZoneIndex());
+		auto info = SubdivisionInfo<TData::subpavingDim>{
+			getSubdivisionRatio(data, zone.getLevel(), activeId)};
+		auto numSubRegions = info.getRatio().getProduct();
+		bool selectAll = false;
+		if (refine::detail::getImpliedDecision(data.detector.selectTag,
+				data.classifications(activeId), selectAll)) {
+			count = selectAll ? numSubRegions : 0;
+		}
+		else {
+			Kokkos::parallel_reduce(
+				Kokkos::TeamThreadRange(member, numSubRegions),
+				[&](IdType i, IdType& running) {
+					auto subRegion = getSubZoneRegion(zoneRegion, i, info);
+					if (data.detector(data.detector.selectTag, subRegion)) {
+						++running;
+					}
+				},
+				count);
+			selectCalls = numSubRegions;
+		}
+	}
+
+	Kokkos::single(Kokkos::PerTeam(member), [&]() {
+		runningTotals.selectCalls += selectCalls;
+		recordNewZoneCount(data, activeId, count, runningTotals);
+	});
+}
+
+/*!
+ * @brief Team version of fillSelectedSubZones(), in which the threads of the
+ * team evaluate the selection of the candidate sub-zones into team scratch
+ * and compact the selected ones with a team scan
+ *
+ * The team scratch must hold a SelectionFlagsView with an element for each
+ * candidate sub-zone.
+ */
+template <typename TData, typename TTeamMember>
+KOKKOS_INLINE_FUNCTION
+void
+fillSelectedSubZonesTeam(
+	const TData& data, const TTeamMember& member, IdType& selectCalls)
+{
+	using FlagsView =
+		SelectionFlagsView<typename TTeamMember::scratch_memory_space>;
+
+	auto activeId = static_cast<IdType>(member.league_rank());
+	if (data.newZoneCounts(activeId) == 0) {
+		return;
 	}
+	const auto& tile = data.tiles(data.activeTiles(activeId));
+	const auto& zone = data.zonesRA(tile.getOwningZoneIndex());
+	auto zoneRegion = getActiveZoneRegion(data, activeId);
+	auto info = SubdivisionInfo<TData::subpavingDim>{
+		getSubdivisionRatio(data, zone.getLevel(), activeId)};
+	auto numSubRegions = info.getRatio().getProduct();
+	auto selectedBegin = data.subZoneStarts(activeId);
+
+	// A tile with an implied selection has all of its sub-zones selected
+	bool selectAll = false;
+	if (refine::detail::getImpliedDecision(data.detector.selectTag,
+			data.classifications(activeId), selectAll)) {
+		Kokkos::parallel_for(
+			Kokkos::TeamThreadRange(member, numSubRegions), [&](IdType i) {
+				data.selectedSubZones(selectedBegin + i) = i;
+			});
+		return;
+	}
+
+	// The scan may call its functor more than once for each sub-zone, so the
+	// selection is evaluated beforehand
+	auto selected = FlagsView(member.team_scratch(0), numSubRegions);
+	Kokkos::parallel_for(
+		Kokkos::TeamThreadRange(member, numSubRegions), [&](IdType i) {
+			auto subRegion = getSubZoneRegion(zoneRegion, i, info);
+			selected(i) = data.detector(data.detector.selectTag, subRegion);
+		});
+	member.team_barrier();
+
+	Kokkos::parallel_scan(Kokkos::TeamThreadRange(member, numSubRegions),
+		[&](IdType i, IdType& position, const bool finalPass) {
+			if (selected(i)) {
+				if (finalPass) {
+					data.selectedSubZones(selectedBegin + position) = i;
+				}
+				++position;
+			}
+		});
+	Kokkos::single(
+		Kokkos::PerTeam(member), [&]() { selectCalls += numSubRegions; });
 }
 
 template <typename TData>
 KOKKOS_INLINE_FUNCTION
 void
-refineTile(const TData& data, IdType index)
+refineTile(const TData& data, IdType activeId)
 {
 	using ZoneType = typename TData::ZoneType;
 	using TileType = typename TData::TileType;
+	using ItemDataType = typename TData::ItemDataView::value_type;
 
-	auto newZones = data.newZoneCounts(index);
+	auto newZones = data.newZoneCounts(activeId);
 	if (newZones == 0) {
 		return;
 	}
 
+	auto ownerRegion = getActiveZoneRegion(data, activeId);
+	auto index = data.activeTiles(activeId);
 	auto& tile = data.tiles(index);
 	auto ownerZoneId = tile.getOwningZoneIndex();
-	auto& ownerZone = data.zones(ownerZoneId);
+	auto&& ownerZone = data.zones(ownerZoneId);
 	auto level = ownerZone.getLevel();
 	auto newLevel = level + 1;
 	auto info = SubdivisionInfo<TData::subpavingDim>{
-		getSubdivisionRatio(data, level, index)};
+		getSubdivisionRatio(data, level, activeId)};
 
 	// Create first new zone, replace current tile and associate
-	auto subZoneBeginId = data.numZones + data.subZoneStarts(index);
-	data.zones(subZoneBeginId) = ZoneType{
-		getSubZoneRegion(ownerZone, data.selectedSubZones(index, 0), info),
-		newLevel, ownerZoneId};
+	auto activeBeginId = data.subZoneStarts(activeId);
+	auto subZoneBeginId = data.numZones + activeBeginId;
+	auto localId = data.selectedSubZones(activeBeginId);
+	auto subRegion = getSubZoneRegion(ownerRegion, localId, info);
+	data.zones(subZoneBeginId) =
+		makeZone<ZoneType>(subRegion, localId, newLevel, ownerZoneId);
 	data.zones(subZoneBeginId).setTileIndex(index);
-	tile = TileType{data.zonesRA(subZoneBeginId).getRegion(), subZoneBeginId};
+	tile = TileType{subRegion, subZoneBeginId};
+	auto itemData = (data.itemDataInit == ItemDataInit::copyParent) ?
+		data.itemData(index) :
+		ItemDataType{};
+	data.itemData(index) = itemData;
+
+	// Only the tiles produced here can be refined at the next level, and they
+	// are gathered in the same order as their zones
+	data.nextActiveTiles(activeBeginId) = index;
+	auto classification = data.classifications(activeId);
+	data.nextClassifications(activeBeginId) = classification;
 
 	// Create and associate remaining zones and tiles
-	auto tileBeginId = data.numTiles + data.newTileStarts(index);
+	auto tileBeginId = data.numTiles + data.newTileStarts(activeId);
 	for (IdType i = 1; i < newZones; ++i) {
 		auto zoneId = subZoneBeginId + i;
 		auto tileId = tileBeginId + i - 1;
-		data.zones(zoneId) = ZoneType{
-			getSubZoneRegion(ownerZone, data.selectedSubZones(index, i), info),
-			newLevel, ownerZoneId};
+		localId = data.selectedSubZones(activeBeginId + i);
+		subRegion = getSubZoneRegion(ownerRegion, localId, info);
+		data.zones(zoneId) =
+			makeZone<ZoneType>(subRegion, localId, newLevel, ownerZoneId);
 		data.zones(zoneId).setTileIndex(tileId);
-		data.tiles(tileId) = TileType{data.zonesRA(zoneId).getRegion(), zoneId};
+		data.tiles(tileId) = TileType{subRegion, zoneId};
+		data.itemData(tileId) = itemData;
+		data.nextActiveTiles(activeBeginId + i) = tileId;
+		data.nextClassifications(activeBeginId + i) = classification;
 	}
 
 	ownerZone.removeTile();
 	ownerZone.setSubZoneIndices({subZoneBeginId, subZoneBeginId + newZones});
+	setSubZoneInfo(ownerZone, info);
 }
 
 template <typename TSubpaving, typename TDetector>
-Refiner<TSubpaving, TDetector>::Refiner(
-	SubpavingType& subpaving, const DetectorType& detector) :
+Refiner<TSubpaving, TDetector>::Refiner(SubpavingType& subpaving,
+	const DetectorType& detector,
+	RefinementWorkspace<subpavingDim>& workspace) :
 	_subpaving(subpaving),
+	_workspace(workspace),
 	_subdivInfoMirror(create_mirror_view(subpaving._subdivisionInfos)),
 	_data{subpaving._zones, subpaving._zonesRA, subpaving._tiles,
-		subpaving._subdivisionInfos, detector,
+		subpaving._itemData, subpaving._subdivisionInfos,
+		subpaving._rootRegion, subpaving._itemDataInit, detector,
 		(detector.depth() == detector.fullDepth) ?
 			subpaving._subdivisionInfos.size() :
 			detector.depth()}
@@ -165,69 +398,220 @@ Refiner<TSubpaving, TDetector>::Refiner(
 }
 
 template <typename TSubpaving, typename TDetector>
-void
+RefinementReport
 Refiner<TSubpaving, TDetector>::operator()()
 {
-	for (_data.currLevel = 0; _data.currLevel < _data.targetDepth;
-		 ++_data.currLevel) {
+	RefinementReport report;
+	Kokkos::Profiling::pushRegion("plsm::Refine");
+
+	// Initialization is accounted to the first level
+	Kokkos::Timer timer;
+	initializeActiveTiles();
+	refineLevels(_data.targetDepth, timer, report);
+
+	_subpaving.setRefinementDepth(_data.currLevel);
+	Kokkos::Profiling::popRegion();
+
+	return report;
+}
+
+template <typename TSubpaving, typename TDetector>
+RefinementReport
+Refiner<TSubpaving, TDetector>::operator()(
+	const Kokkos::View<IdType*>& tileIds)
+{
+	RefinementReport report;
+	if (tileIds.size() == 0) {
+		return report;
+	}
+	Kokkos::Profiling::pushRegion("plsm::Refine");
+
+	Kokkos::Timer timer;
+	initializeActiveTiles(tileIds);
+	refineLevels(
+		std::min(_data.currLevel + 1, _data.targetDepth), timer, report);
+
+	Kokkos::Profiling::popRegion();
+
+	return report;
+}
+
+template <typename TSubpaving, typename TDetector>
+void
+Refiner<TSubpaving, TDetector>::refineLevels(
+	std::size_t endLevel, Kokkos::Timer& timer, RefinementReport& report)
+{
+	auto scratchSize = _workspace.getDeviceMemorySize();
+	for (; _data.currLevel < endLevel; ++_data.currLevel) {
+		_levelReport = RefinementLevelReport{};
+		_levelReport.level = _data.currLevel;
+		_levelReport.tilesExamined = _data.numActiveTiles;
+
+		Kokkos::Profiling::pushRegion("plsm::Refine::Count");
 		countNewItems();
+		Kokkos::Profiling::popRegion();
+		_levelReport.countTime = timer.seconds();
+
+		if (_data.newItemTotals.zones != 0) {
+			timer.reset();
+			Kokkos::Profiling::pushRegion("plsm::Refine::Scan");
+			findNewItemIndices();
+			Kokkos::Profiling::popRegion();
+			_levelReport.scanTime = timer.seconds();
+
+			timer.reset();
+			Kokkos::Profiling::pushRegion("plsm::Refine::Assign");
+			assignNewItems();
+			Kokkos::Profiling::popRegion();
+			_levelReport.assignTime = timer.seconds();
+		}
+
+		auto newScratchSize = _workspace.getDeviceMemorySize();
+		_levelReport.scratchBytesAllocated = newScratchSize - scratchSize;
+		scratchSize = newScratchSize;
+		_levelReport.deviceMemorySize =
+			_subpaving.getDeviceMemorySize() + scratchSize;
+		report.levels.push_back(_levelReport);
 
 		if (_data.newItemTotals.zones == 0) {
 			break;
 		}
+		timer.reset();
+	}
+}
+
+template <typename TSubpaving, typename TDetector>
+void
+Refiner<TSubpaving, TDetector>::updateWorkspace(IdType numNewZones)
+{
+	_workspace.reserve(_data.numActiveTiles, numNewZones);
+	_data.newZoneCounts = _workspace._newZoneCounts;
+	_data.subZoneStarts = _workspace._subZoneStarts;
+	_data.newTileStarts = _workspace._newTileStarts;
+	_data.selectedSubZones = _workspace._selectedSubZones;
+	_data.activeTiles = _workspace._activeTiles;
+	_data.nextActiveTiles = _workspace._nextActiveTiles;
+	_data.classifications = _workspace._classifications;
+	_data.nextClassifications = _workspace._nextClassifications;
+	_data.enableRefine = _workspace._enableRefine;
+	_data.selectionMasks = _workspace._selectionMasks;
+}
+
+template <typename TSubpaving, typename TDetector>
+void
+Refiner<TSubpaving, TDetector>::initializeActiveTiles()
+{
+	// Every existing tile is a candidate at the start of refinement
+	auto numTiles = _data.numTiles;
+	_data.numActiveTiles = numTiles;
+	updateWorkspace(0);
+	auto activeTiles = _data.activeTiles;
+	auto classifications = _data.classifications;
+	Kokkos::parallel_for(
+		"InitializeActiveTiles", numTiles, KOKKOS_LAMBDA(IdType i) {
+			activeTiles(i) = i;
+			classifications(i) = refine::Classification::boundary;
+		});
+	Kokkos::fence();
+	_data.currLevel = 0;
+}
 
-		findNewItemIndices();
+template <typename TSubpaving, typename TDetector>
+void
+Refiner<TSubpaving, TDetector>::initializeActiveTiles(
+	const Kokkos::View<IdType*>& tileIds)
+{
+	_data.numActiveTiles = static_cast<IdType>(tileIds.size());
+	updateWorkspace(0);
+	auto activeTiles = _data.activeTiles;
+	auto classifications = _data.classifications;
+	auto zones = _data.zonesRA;
+	auto tiles = _data.tiles;
+	std::size_t minLevel = 0;
+	Kokkos::parallel_reduce(
+		"InitializeSeededActiveTiles", _data.numActiveTiles,
+		KOKKOS_LAMBDA(IdType i, std::size_t & running) {
+			auto tileId = tileIds(i);
+			activeTiles(i) = tileId;
+			classifications(i) = refine::Classification::boundary;
+			auto level = zones(tiles(tileId).getOwningZoneIndex()).getLevel();
+			if (level < running) {
+				running = level;
+			}
+		},
+		Kokkos::Min<std::size_t>(minLevel));
+	Kokkos::fence();
+	_data.currLevel = minLevel;
+}
 
-		assignNewItems();
+template <typename TSubpaving, typename TDetector>
+IdType
+Refiner<TSubpaving, TDetector>::getMaxRatioProduct() const
+{
+	// Active tiles at the current level come from zones at or below it
+	auto endLevel = std::min(_data.targetDepth, _subdivInfoMirror.size());
+	IdType maxRatioProduct = 0;
+	for (auto level = _data.currLevel; level < endLevel; ++level) {
+		maxRatioProduct = std::max<IdType>(
+			maxRatioProduct, _subdivInfoMirror(level).getRatio().getProduct());
 	}
+	return maxRatioProduct;
+}
 
-	_subpaving.setZones(_data.zones);
-	_subpaving.setTiles(_data.tiles);
-	_subpaving.setRefinementDepth(_data.currLevel);
+template <typename TSubpaving, typename TDetector>
+bool
+Refiner<TSubpaving, TDetector>::useTeamSelection() const
+{
+	return getMaxRatioProduct() >= teamSelectionThreshold;
 }
 
 template <typename TSubpaving, typename TDetector>
 void
 Refiner<TSubpaving, TDetector>::countNewItems()
 {
-	auto numTiles = _data.tiles.size();
-	_data.newZoneCounts =
-		Kokkos::View<IdType*>(AllocNoInit{"New Zone Counts"}, numTiles);
-	auto numSubZones =
-		_subdivInfoMirror[_data.currLevel].getRatio().getProduct();
-	_data.selectedSubZones = Kokkos::View<IdType**>(
-		AllocNoInit{"Selected Sub-Zones"}, numTiles, numSubZones);
-	std::for_each(begin(_data.enableRefine), end(_data.enableRefine),
-		[numTiles](auto&& bitset) {
-			using Bitset = std::remove_reference_t<decltype(bitset)>;
-			bitset = Bitset(static_cast<unsigned>(numTiles));
-		});
-	ItemTotals counts{};
+	using TeamPolicy = Kokkos::TeamPolicy<>;
+	using TeamMember = typename TeamPolicy::member_type;
+
+	auto numActiveTiles = _data.numActiveTiles;
+	updateWorkspace(0);
+	_teamSelection = useTeamSelection();
+	CountTotals counts{};
 	auto data = _data;
-	Kokkos::parallel_reduce(
-		"CountNewItemsFromTile", numTiles,
-		KOKKOS_LAMBDA(IdType id, ItemTotals & running) {
-			countNewItemsFromTile(data, id, running);
-		},
-		counts);
+	if (_teamSelection) {
+		Kokkos::parallel_reduce("CountNewItemsFromTileTeam",
+			TeamPolicy(static_cast<int>(numActiveTiles), Kokkos::AUTO),
+			KOKKOS_LAMBDA(const TeamMember& member, CountTotals& running) {
+				countNewItemsFromTileTeam(data, member, running);
+			},
+			counts);
+	}
+	else {
+		Kokkos::parallel_reduce(
+			"CountNewItemsFromTile", numActiveTiles,
+			KOKKOS_LAMBDA(IdType id, CountTotals & running) {
+				countNewItemsFromTile(data, id, running);
+			},
+			counts);
+	}
 	Kokkos::fence();
-	_data.newItemTotals = counts;
+	_data.newItemTotals = counts.items;
+	_levelReport.refineCalls = counts.refineCalls;
+	_levelReport.selectCalls = counts.selectCalls;
 }
 
 template <typename TSubpaving, typename TDetector>
 void
 Refiner<TSubpaving, TDetector>::findNewItemIndices()
 {
-	auto numTiles = _data.tiles.size();
-	auto subZoneStarts =
-		Kokkos::View<IdType*>(AllocNoInit{"SubZone Start Ids"}, numTiles);
-	auto newTileStarts =
-		Kokkos::View<IdType*>(AllocNoInit{"Tile Start Ids"}, numTiles);
+	auto numActiveTiles = _data.numActiveTiles;
+	updateWorkspace(_data.newItemTotals.zones);
+	auto subZoneStarts = _data.subZoneStarts;
+	auto newTileStarts = _data.newTileStarts;
 	auto newZoneCounts = _data.newZoneCounts;
 
 	// Initialize starts
 	Kokkos::parallel_for(
-		"InitializeNewItemStarts", numTiles, KOKKOS_LAMBDA(IdType i) {
+		"InitializeNewItemStarts", numActiveTiles, KOKKOS_LAMBDA(IdType i) {
 			auto newZoneCount = newZoneCounts(i);
 			subZoneStarts(i) = newZoneCount;
 			newTileStarts(i) = (newZoneCount == 0) ? 0 : newZoneCount - 1;
@@ -235,7 +619,7 @@ Refiner<TSubpaving, TDetector>::findNewItemIndices()
 
 	ItemTotals totals{};
 	Kokkos::parallel_scan(
-		"ScanNewItemStarts", numTiles,
+		"ScanNewItemStarts", numActiveTiles,
 		KOKKOS_LAMBDA(IdType i, ItemTotals & update, const bool finalPass) {
 			const auto tmpZones = subZoneStarts(i);
 			const auto tmpTiles = newTileStarts(i);
@@ -249,26 +633,62 @@ Refiner<TSubpaving, TDetector>::findNewItemIndices()
 		totals);
 
 	Kokkos::fence();
-	_data.subZoneStarts = subZoneStarts;
-	_data.newTileStarts = newTileStarts;
+
+	// Now that the selected sub-zones have been counted and their positions
+	// are known, record (only) those
+	auto data = _data;
+	IdType selectCalls = 0;
+	if (_teamSelection) {
+		using TeamPolicy = Kokkos::TeamPolicy<>;
+		using TeamMember = typename TeamPolicy::member_type;
+		using FlagsView =
+			SelectionFlagsView<typename TeamMember::scratch_memory_space>;
+		auto scratchSize = FlagsView::shmem_size(getMaxRatioProduct());
+		Kokkos::parallel_reduce("FillSelectedSubZonesTeam",
+			TeamPolicy(static_cast<int>(numActiveTiles), Kokkos::AUTO)
+				.set_scratch_size(0, Kokkos::PerTeam(scratchSize)),
+			KOKKOS_LAMBDA(const TeamMember& member, IdType& running) {
+				fillSelectedSubZonesTeam(data, member, running);
+			},
+			selectCalls);
+	}
+	else {
+		Kokkos::parallel_for(
+			"FillSelectedSubZones", numActiveTiles,
+			KOKKOS_LAMBDA(IdType id) { fillSelectedSubZones(data, id); });
+	}
+	Kokkos::fence();
+	_levelReport.selectCalls += selectCalls;
 }
 
 template <typename TSubpaving, typename TDetector>
 void
 Refiner<TSubpaving, TDetector>::assignNewItems()
 {
-	Kokkos::resize(_data.zones, _data.numZones + _data.newItemTotals.zones);
+	// The subpaving keeps spare capacity, so this only reallocates (and
+	// copies) when it runs out
+	_subpaving.resizeZones(_data.numZones + _data.newItemTotals.zones);
+	_data.zones = _subpaving._zones;
 	_data.zonesRA = _data.zones;
-	Kokkos::resize(_data.tiles, _data.numTiles + _data.newItemTotals.tiles);
+	_subpaving.resizeTiles(_data.numTiles + _data.newItemTotals.tiles);
+	_data.tiles = _subpaving._tiles;
+	_data.itemData = _subpaving._itemData;
 
 	auto data = _data;
 	Kokkos::parallel_for(
-		"RefineTile", data.numTiles,
+		"RefineTile", data.numActiveTiles,
 		KOKKOS_LAMBDA(IdType id) { refineTile(data, id); });
 	Kokkos::fence();
 
 	_data.numZones = static_cast<IdType>(_data.zones.size());
 	_data.numTiles = static_cast<IdType>(_data.tiles.size());
+	_levelReport.zonesCreated = _data.newItemTotals.zones;
+	_levelReport.tilesCreated = _data.newItemTotals.tiles;
+
+	// Tiles which were not refined at this level cannot be refined at any
+	// later level, so only keep those produced by refinement
+	_workspace.advanceLevel();
+	_data.numActiveTiles = _data.newItemTotals.zones;
 }
 } // namespace detail
 } // namespace plsm
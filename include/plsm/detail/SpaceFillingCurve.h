@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Kokkos_Array.hpp>
+
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+/*!
+ * @brief Space-filling curves available for ordering points and tiles
+ */
+enum class SpaceFillingCurve
+{
+	//! Z-order, from interleaving the bits of the coordinates
+	morton,
+	//! Hilbert order, in which consecutive cells are always adjacent
+	hilbert
+};
+
+namespace detail
+{
+//! Number of bits per coordinate available within a 64-bit curve key
+template <DimType Dim>
+inline constexpr unsigned curveKeyBits = static_cast<unsigned>(64 / Dim);
+
+/*!
+ * @brief Coordinates (on a space-filling curve grid) for a point
+ */
+template <DimType Dim>
+using CurveCoordinates = Kokkos::Array<std::uint64_t, Dim>;
+
+/*!
+ * @brief Get the right shift needed for offsets within the given extent to fit
+ * in the number of bits available per coordinate
+ */
+template <DimType Dim>
+inline unsigned
+getCurveKeyShift(std::uint64_t maxExtent) noexcept
+{
+	unsigned bits = 0;
+	while (bits < 64 && (std::uint64_t{1} << bits) < maxExtent) {
+		++bits;
+	}
+	return (bits > curveKeyBits<Dim>) ? bits - curveKeyBits<Dim> : 0;
+}
+
+/*!
+ * @brief Get the curve coordinates of the given point as offsets from the
+ * origin of the given Region
+ *
+ * Points outside the Region are clamped to it.
+ *
+ * @param shift Right shift (see getCurveKeyShift()) applied to each offset
+ */
+template <typename TRegion, typename TPoint>
+KOKKOS_INLINE_FUNCTION
+CurveCoordinates<TRegion::dimension()>
+getCurveCoordinates(
+	const TRegion& region, const TPoint& point, unsigned shift) noexcept
+{
+	CurveCoordinates<TRegion::dimension()> ret;
+	for (DimType i = 0; i < TRegion::dimension(); ++i) {
+		const auto& ival = region[i];
+		std::uint64_t offset = 0;
+		if (point[i] >= ival.end()) {
+			offset = ival.length() - 1;
+		}
+		else if (point[i] > ival.begin()) {
+			offset = static_cast<std::uint64_t>(point[i] - ival.begin());
+		}
+		ret[i] = offset >> shift;
+	}
+	return ret;
+}
+
+/*!
+ * @brief Compute the Morton (Z-order) key for the given curve coordinates by
+ * interleaving their bits
+ */
+template <DimType Dim>
+KOKKOS_INLINE_FUNCTION
+std::uint64_t
+getMortonKey(const CurveCoordinates<Dim>& coords) noexcept
+{
+	std::uint64_t key = 0;
+	for (unsigned b = 0; b < curveKeyBits<Dim>; ++b) {
+		for (DimType i = 0; i < Dim; ++i) {
+			auto bit = (coords[i] >> b) & std::uint64_t{1};
+			key |= bit << (b * Dim + (Dim - 1 - i));
+		}
+	}
+	return key;
+}
+
+/*!
+ * @brief Compute the Hilbert key for the given curve coordinates
+ *
+ * The coordinates are first transformed (in place, using Skilling's
+ * algorithm) into the "transposed" Hilbert index, whose bits are then
+ * interleaved as for the Morton key.
+ */
+template <DimType Dim>
+KOKKOS_INLINE_FUNCTION
+std::uint64_t
+getHilbertKey(CurveCoordinates<Dim> coords) noexcept
+{
+	constexpr auto topBit = std::uint64_t{1} << (curveKeyBits<Dim> - 1);
+
+	// Inverse undo
+	for (auto q = topBit; q > 1; q >>= 1) {
+		auto p = q - 1;
+		for (DimType i = 0; i < Dim; ++i) {
+			if (coords[i] & q) {
+				coords[0] ^= p;
+			}
+			else {
+				auto t = (coords[0] ^ coords[i]) & p;
+				coords[0] ^= t;
+				coords[i] ^= t;
+			}
+		}
+	}
+
+	// Gray encode
+	for (DimType i = 1; i < Dim; ++i) {
+		coords[i] ^= coords[i - 1];
+	}
+	std::uint64_t t = 0;
+	for (auto q = topBit; q > 1; q >>= 1) {
+		if (coords[Dim - 1] & q) {
+			t ^= q - 1;
+		}
+	}
+	for (DimType i = 0; i < Dim; ++i) {
+		coords[i] ^= t;
+	}
+
+	return getMortonKey<Dim>(coords);
+}
+
+/*!
+ * @brief Compute the key along the given curve for the given curve
+ * coordinates
+ */
+template <DimType Dim>
+KOKKOS_INLINE_FUNCTION
+std::uint64_t
+getCurveKey(
+	SpaceFillingCurve curve, const CurveCoordinates<Dim>& coords) noexcept
+{
+	return (curve == SpaceFillingCurve::hilbert) ? getHilbertKey<Dim>(coords) :
+												   getMortonKey<Dim>(coords);
+}
+} // namespace detail
+} // namespace plsm
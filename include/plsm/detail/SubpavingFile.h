@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+namespace detail
+{
+//! Version of the binary format written by Subpaving::save()
+inline constexpr std::uint32_t subpavingFileVersion = 2;
+
+//! Bits of SubpavingFileHeader::options for the build options which change
+//! what the zones and tiles store
+inline constexpr std::uint32_t compactTilesFileOption = 1u << 0;
+inline constexpr std::uint32_t implicitZoneRegionsFileOption = 1u << 1;
+inline constexpr std::uint32_t packedZonesFileOption = 1u << 2;
+
+/*!
+ * @brief Get the SubpavingFileHeader::options for this build
+ */
+inline constexpr std::uint32_t
+getSubpavingFileOptions() noexcept
+{
+	std::uint32_t ret = 0;
+#if defined(PLSM_USE_COMPACT_TILES)
+	ret |= compactTilesFileOption;
+#endif
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	ret |= implicitZoneRegionsFileOption;
+#endif
+#if defined(PLSM_USE_PACKED_ZONES)
+	ret |= packedZonesFileOption;
+#endif
+	return ret;
+}
+
+//! Alignment (in bytes) of each array within a subpaving file, so that the
+//! arrays can be used in place when the file is mapped into memory
+inline constexpr std::uint64_t subpavingFileAlignment = 64;
+
+/*!
+ * @brief Header at the beginning of a subpaving file
+ *
+ * The header describes the layout of the stored types, so that a file is
+ * only ever read back as the same Subpaving type (on a machine with the same
+ * byte order). It is followed by the root region, the subdivision infos, the
+ * zones, the tiles, and the item data of the tiles, each starting at the
+ * given offset (in bytes, from the beginning of the file).
+ */
+struct SubpavingFileHeader
+{
+	char magic[8]{'P', 'L', 'S', 'M', 'S', 'P', 'V', 'G'};
+	std::uint32_t version{subpavingFileVersion};
+	std::uint32_t dimension{};
+	std::uint32_t scalarSize{};
+	std::uint32_t regionSize{};
+	std::uint32_t subdivisionInfoSize{};
+	std::uint32_t zoneSize{};
+	std::uint32_t tileSize{};
+	std::uint32_t itemDataSize{};
+	//! Build options in effect (see getSubpavingFileOptions()), since the
+	//! sizes alone may not tell the layouts apart
+	std::uint32_t options{getSubpavingFileOptions()};
+
+	std::uint64_t numSubdivisionInfos{};
+	std::uint64_t numZones{};
+	std::uint64_t numTiles{};
+	std::uint64_t refinementDepth{};
+
+	std::uint64_t rootRegionOffset{};
+	std::uint64_t subdivisionInfosOffset{};
+	std::uint64_t zonesOffset{};
+	std::uint64_t tilesOffset{};
+	std::uint64_t itemDataOffset{};
+	std::uint64_t fileSize{};
+
+	/*!
+	 * @brief Compute the offsets (and file size) from the counts and sizes
+	 */
+	void
+	computeOffsets() noexcept
+	{
+		auto offset = alignOffset(sizeof(SubpavingFileHeader));
+		rootRegionOffset = offset;
+		offset = alignOffset(offset + regionSize);
+		subdivisionInfosOffset = offset;
+		offset =
+			alignOffset(offset + numSubdivisionInfos * subdivisionInfoSize);
+		zonesOffset = offset;
+		offset = alignOffset(offset + numZones * zoneSize);
+		tilesOffset = offset;
+		offset = alignOffset(offset + numTiles * tileSize);
+		itemDataOffset = offset;
+		fileSize = itemDataOffset + numTiles * itemDataSize;
+	}
+
+	/*!
+	 * @brief Check that this header (read from the given file) matches the
+	 * given expected header, which describes the type being loaded
+	 */
+	void
+	validate(const SubpavingFileHeader& expected, const std::string& path,
+		std::uint64_t actualFileSize) const
+	{
+		auto fail = [&path](const std::string& reason) {
+			throw std::runtime_error(
+				"Subpaving: cannot load " + path + ": " + reason);
+		};
+		if (std::memcmp(magic, expected.magic, sizeof(magic)) != 0) {
+			fail("not a subpaving file");
+		}
+		if (version != expected.version) {
+			fail("unsupported version " + std::to_string(version));
+		}
+		if (dimension != expected.dimension ||
+			scalarSize != expected.scalarSize ||
+			regionSize != expected.regionSize ||
+			subdivisionInfoSize != expected.subdivisionInfoSize ||
+			zoneSize != expected.zoneSize || tileSize != expected.tileSize ||
+			itemDataSize != expected.itemDataSize) {
+			fail("stored for a different subpaving type");
+		}
+		if (options != expected.options) {
+			fail("stored with different build options");
+		}
+		auto check = *this;
+		check.computeOffsets();
+		if (check.rootRegionOffset != rootRegionOffset ||
+			check.subdivisionInfosOffset != subdivisionInfosOffset ||
+			check.zonesOffset != zonesOffset ||
+			check.tilesOffset != tilesOffset ||
+			check.itemDataOffset != itemDataOffset ||
+			check.fileSize != fileSize ||
+			actualFileSize < fileSize) {
+			fail("inconsistent or truncated file");
+		}
+	}
+
+	static std::uint64_t
+	alignOffset(std::uint64_t offset) noexcept
+	{
+		return (offset + subpavingFileAlignment - 1) / subpavingFileAlignment *
+			subpavingFileAlignment;
+	}
+};
+} // namespace detail
+} // namespace plsm
@@ -0,0 +1,539 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include <Kokkos_Core.hpp>
+
+#include <plsm/Interval.h>
+#include <plsm/IntervalRange.h>
+#include <plsm/Utility.h>
+
+namespace plsm
+{
+namespace detail
+{
+/*!
+ * @brief ZoneReference refers to the fields of one zone stored in
+ * ZoneColumns, with the same accessors as Zone
+ *
+ * A reference to a read-only zone rebinds on assignment (like a pointer),
+ * so that a search can step from zone to zone. A reference to a writable
+ * zone assigns the fields instead (like a Zone&).
+ */
+template <typename TZone, bool ReadOnly>
+class ZoneReference
+{
+	template <typename, bool>
+	friend class ZoneReference;
+
+	template <typename T>
+	using Pointer = std::conditional_t<ReadOnly, const T*, T*>;
+
+public:
+	using ZoneType = TZone;
+	using RegionType = typename ZoneType::RegionType;
+	using LevelType = typename ZoneType::LevelType;
+
+	KOKKOS_INLINE_FUNCTION
+	ZoneReference(
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+		Pointer<IdType> localId, Pointer<std::uint8_t> subZoneAxes,
+#else
+		Pointer<RegionType> region,
+#endif
+		Pointer<LevelType> level, Pointer<IdType> parentId,
+		Pointer<Interval<IdType>> subZoneIds,
+		Pointer<IdType> tileId) noexcept :
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+		_localId(localId),
+		_subZoneAxes(subZoneAxes),
+#else
+		_region(region),
+#endif
+		_level(level),
+		_parentId(parentId),
+		_subZoneIds(subZoneIds),
+		_tileId(tileId)
+	{
+	}
+
+	ZoneReference(const ZoneReference&) = default;
+
+	/*!
+	 * @brief Refer to the given writable zone read-only
+	 */
+	template <bool OtherReadOnly,
+		typename = std::enable_if_t<ReadOnly && !OtherReadOnly>>
+	KOKKOS_INLINE_FUNCTION
+	ZoneReference(const ZoneReference<ZoneType, OtherReadOnly>& other) noexcept
+		:
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+		_localId(other._localId),
+		_subZoneAxes(other._subZoneAxes),
+#else
+		_region(other._region),
+#endif
+		_level(other._level),
+		_parentId(other._parentId),
+		_subZoneIds(other._subZoneIds),
+		_tileId(other._tileId)
+	{
+	}
+
+	/*!
+	 * @brief Refer to the given zone (if read-only), or assign its fields
+	 */
+	KOKKOS_INLINE_FUNCTION
+	ZoneReference&
+	operator=(const ZoneReference& other)
+	{
+		if constexpr (ReadOnly) {
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+			_localId = other._localId;
+			_subZoneAxes = other._subZoneAxes;
+#else
+			_region = other._region;
+#endif
+			_level = other._level;
+			_parentId = other._parentId;
+			_subZoneIds = other._subZoneIds;
+			_tileId = other._tileId;
+			return *this;
+		}
+		else {
+			return *this = static_cast<ZoneType>(other);
+		}
+	}
+
+	/*!
+	 * @brief Assign the fields of the given Zone
+	 */
+	KOKKOS_INLINE_FUNCTION
+	ZoneReference&
+	operator=(const ZoneType& zone)
+	{
+		static_assert(!ReadOnly, "Cannot assign to a read-only zone");
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+		*_localId = zone.getLocalIndex();
+		*_subZoneAxes = zone.getSubZoneAxes();
+#else
+		*_region = zone.getRegion();
+#endif
+		*_level = static_cast<LevelType>(zone.getLevel());
+		*_parentId = zone.getParentIndex();
+		*_subZoneIds = zone.getSubZoneIndices();
+		*_tileId = zone.getTileIndex();
+		return *this;
+	}
+
+	/*!
+	 * @brief Gather the fields into a Zone
+	 */
+	KOKKOS_INLINE_FUNCTION
+	operator ZoneType() const
+	{
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+		ZoneType zone{*_localId, *_level, *_parentId};
+		zone.setSubZoneAxes(*_subZoneAxes);
+#else
+		ZoneType zone{*_region, *_level, *_parentId};
+#endif
+		zone.setSubZoneIndices(*_subZoneIds);
+		zone.setTileIndex(*_tileId);
+		return zone;
+	}
+
+	static KOKKOS_INLINE_FUNCTION
+	constexpr DimType
+	dimension() noexcept
+	{
+		return ZoneType::dimension();
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	bool
+	hasTile() const noexcept
+	{
+		return (*_tileId != invalid<IdType>);
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	IdType
+	getTileIndex() const noexcept
+	{
+		return *_tileId;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	void
+	setTileIndex(IdType tileId) const noexcept
+	{
+		static_assert(!ReadOnly, "Cannot modify a read-only zone");
+		*_tileId = tileId;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	void
+	removeTile() const noexcept
+	{
+		setTileIndex(invalid<IdType>);
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	std::size_t
+	getLevel() const noexcept
+	{
+		return *_level;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	Interval<IdType>
+	getSubZoneIndices() const noexcept
+	{
+		return *_subZoneIds;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	void
+	setSubZoneIndices(const Interval<IdType>& subZoneIds) const noexcept
+	{
+		static_assert(!ReadOnly, "Cannot modify a read-only zone");
+		*_subZoneIds = subZoneIds;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	IntervalRange<IdType>
+	getSubZoneRange() const noexcept
+	{
+		return IntervalRange<IdType>{getSubZoneIndices()};
+	}
+
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	KOKKOS_INLINE_FUNCTION
+	IdType
+	getLocalIndex() const noexcept
+	{
+		return *_localId;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	std::uint8_t
+	getSubZoneAxes() const noexcept
+	{
+		return *_subZoneAxes;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	void
+	setSubZoneAxes(std::uint8_t axes) const noexcept
+	{
+		static_assert(!ReadOnly, "Cannot modify a read-only zone");
+		*_subZoneAxes = axes;
+	}
+#else
+	KOKKOS_INLINE_FUNCTION
+	const RegionType&
+	getRegion() const noexcept
+	{
+		return *_region;
+	}
+#endif
+
+	KOKKOS_INLINE_FUNCTION
+	bool
+	hasParent() const noexcept
+	{
+		return (*_parentId != invalid<IdType>);
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	IdType
+	getParentIndex() const noexcept
+	{
+		return *_parentId;
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	void
+	setParentIndex(IdType parentId) const noexcept
+	{
+		static_assert(!ReadOnly, "Cannot modify a read-only zone");
+		*_parentId = parentId;
+	}
+
+private:
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	Pointer<IdType> _localId;
+	Pointer<std::uint8_t> _subZoneAxes;
+#else
+	Pointer<RegionType> _region;
+#endif
+	Pointer<LevelType> _level;
+	Pointer<IdType> _parentId;
+	Pointer<Interval<IdType>> _subZoneIds;
+	Pointer<IdType> _tileId;
+};
+
+/*!
+ * @brief ZoneColumns stores a set of zones (with PLSM_USE_SOA_ZONES) as a
+ * structure of arrays: each field of the zones is in a separate view
+ *
+ * A search descending the tree reads only some fields of each zone it
+ * visits (mostly the region and sub-zones), so it does not bring the rest
+ * of each Zone through the cache. ZoneColumns stands in for a view of
+ * zones: indexing it gives a ZoneReference with the accessors of Zone, and
+ * subview(), deep_copy(), and create_mirror_view() work on each view. The
+ * fields are those of a Zone without PLSM_USE_PACKED_ZONES (keeping its
+ * LevelType).
+ *
+ * @tparam ReadOnly Whether the zones are read through read-only
+ * random-access views (like Subpaving::ZonesRAView)
+ */
+template <typename TZone, typename TMemSpace, bool ReadOnly = false>
+class ZoneColumns
+{
+	template <typename, typename, bool>
+	friend class ZoneColumns;
+
+	template <typename T>
+	using ColumnView = std::conditional_t<ReadOnly,
+		Kokkos::View<const T*, TMemSpace, Kokkos::MemoryRandomAccess>,
+		Kokkos::View<T*, TMemSpace>>;
+
+public:
+	using ZoneType = TZone;
+	using RegionType = typename ZoneType::RegionType;
+	using LevelType = typename ZoneType::LevelType;
+	using MemorySpace = TMemSpace;
+	using ReferenceType = ZoneReference<ZoneType, ReadOnly>;
+	using HostMirrorSpace =
+		typename ColumnView<IdType>::traits::host_mirror_space;
+	using HostMirror = ZoneColumns<ZoneType, HostMirrorSpace>;
+
+	ZoneColumns() = default;
+
+	/*!
+	 * @brief Allocate columns for the given number of zones, given a label
+	 * or a Kokkos::ViewAllocateWithoutInitializing
+	 *
+	 * Unless allocated without initializing, the zones are those made by
+	 * Zone().
+	 */
+	template <typename TLabel>
+	ZoneColumns(const TLabel& label, std::size_t numZones) :
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+		_localIds(label, numZones),
+		_subZoneAxes(label, numZones),
+#else
+		_regions(label, numZones),
+#endif
+		_levels(label, numZones),
+		_parentIds(label, numZones),
+		_subZoneIds(label, numZones),
+		_tileIds(label, numZones)
+	{
+		static_assert(!ReadOnly, "Read-only zones are not allocated");
+		if constexpr (!std::is_same_v<TLabel,
+						  Kokkos::ViewAllocateWithoutInitializing>) {
+			Kokkos::deep_copy(_parentIds, invalid<IdType>);
+			Kokkos::deep_copy(_tileIds, invalid<IdType>);
+		}
+	}
+
+	/*!
+	 * @brief Copy the given view of zones into columns
+	 */
+	template <typename... TViewArgs>
+	explicit ZoneColumns(const Kokkos::View<ZoneType*, TViewArgs...>& zones) :
+		ZoneColumns(Kokkos::ViewAllocateWithoutInitializing{zones.label()},
+			zones.size())
+	{
+		auto numZones = static_cast<IdType>(zones.size());
+		auto columns = *this;
+		Kokkos::parallel_for(
+			"CopyToZoneColumns", numZones,
+			KOKKOS_LAMBDA(IdType i) { columns(i) = zones(i); });
+		Kokkos::fence();
+	}
+
+	/*!
+	 * @brief Refer to the given writable zones read-only
+	 */
+	template <bool OtherReadOnly,
+		typename = std::enable_if_t<ReadOnly && !OtherReadOnly>>
+	ZoneColumns(
+		const ZoneColumns<ZoneType, MemorySpace, OtherReadOnly>& other) :
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+		_localIds(other._localIds),
+		_subZoneAxes(other._subZoneAxes),
+#else
+		_regions(other._regions),
+#endif
+		_levels(other._levels),
+		_parentIds(other._parentIds),
+		_subZoneIds(other._subZoneIds),
+		_tileIds(other._tileIds)
+	{
+	}
+
+	/*!
+	 * @brief Get a reference to the fields of the given zone
+	 */
+	KOKKOS_INLINE_FUNCTION
+	ReferenceType
+	operator()(IdType zoneId) const noexcept
+	{
+		return {
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+			&_localIds(zoneId), &_subZoneAxes(zoneId),
+#else
+			&_regions(zoneId),
+#endif
+			&_levels(zoneId), &_parentIds(zoneId), &_subZoneIds(zoneId),
+			&_tileIds(zoneId)};
+	}
+
+	/*!
+	 * @brief Get the number of zones
+	 */
+	KOKKOS_INLINE_FUNCTION
+	std::size_t
+	size() const noexcept
+	{
+		return _levels.size();
+	}
+
+	KOKKOS_INLINE_FUNCTION
+	std::size_t
+	extent(unsigned rank) const noexcept
+	{
+		return _levels.extent(rank);
+	}
+
+	std::string
+	label() const
+	{
+		return _levels.label();
+	}
+
+	/*!
+	 * @brief Get size (in bytes) of memory needed for the given number of
+	 * zones
+	 */
+	static std::uint64_t
+	required_allocation_size(std::size_t numZones)
+	{
+		return
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+			ColumnView<IdType>::required_allocation_size(numZones) +
+			ColumnView<std::uint8_t>::required_allocation_size(numZones) +
+#else
+			ColumnView<RegionType>::required_allocation_size(numZones) +
+#endif
+			ColumnView<LevelType>::required_allocation_size(numZones) +
+			2 * ColumnView<IdType>::required_allocation_size(numZones) +
+			ColumnView<Interval<IdType>>::required_allocation_size(numZones);
+	}
+
+	/*!
+	 * @brief Apply the given function to each pair of corresponding columns
+	 * of these and the other zones (see subview() and deep_copy())
+	 */
+	template <typename TOther, typename TFunction>
+	void
+	forEachColumn(TOther& other, const TFunction& func)
+	{
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+		func(_localIds, other._localIds);
+		func(_subZoneAxes, other._subZoneAxes);
+#else
+		func(_regions, other._regions);
+#endif
+		func(_levels, other._levels);
+		func(_parentIds, other._parentIds);
+		func(_subZoneIds, other._subZoneIds);
+		func(_tileIds, other._tileIds);
+	}
+
+private:
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	//! Index among the candidate sub-zones of the parent
+	ColumnView<IdType> _localIds;
+	//! Axes along which the sub-zones subdivide each zone
+	ColumnView<std::uint8_t> _subZoneAxes;
+#else
+	//! Region of each zone
+	ColumnView<RegionType> _regions;
+#endif
+	//! Subdivision level of each zone
+	ColumnView<LevelType> _levels;
+	//! Index to the parent of each zone
+	ColumnView<IdType> _parentIds;
+	//! Interval of indices to the subzones of each zone
+	ColumnView<Interval<IdType>> _subZoneIds;
+	//! Index to the Tile owned by each zone
+	ColumnView<IdType> _tileIds;
+};
+
+/*!
+ * @brief Get the given range of zones, as with Kokkos::subview()
+ */
+template <typename TZone, typename TMemSpace, typename TRange>
+ZoneColumns<TZone, TMemSpace>
+subview(const ZoneColumns<TZone, TMemSpace>& columns, const TRange& range)
+{
+	ZoneColumns<TZone, TMemSpace> ret;
+	ret.forEachColumn(columns, [&range](auto& part, const auto& column) {
+		part = Kokkos::subview(column, range);
+	});
+	return ret;
+}
+
+/*!
+ * @brief Copy the zones, as with Kokkos::deep_copy()
+ */
+template <typename TZone, typename TMemSpace, typename TSrcMemSpace>
+void
+deep_copy(ZoneColumns<TZone, TMemSpace> dst,
+	const ZoneColumns<TZone, TSrcMemSpace>& src)
+{
+	dst.forEachColumn(src, [](auto& dstColumn, const auto& srcColumn) {
+		Kokkos::deep_copy(dstColumn, srcColumn);
+	});
+}
+
+/*!
+ * @brief Make zones in host memory to mirror the given zones, as with
+ * Kokkos::create_mirror_view()
+ */
+template <typename TZone, typename TMemSpace>
+typename ZoneColumns<TZone, TMemSpace>::HostMirror
+create_mirror_view(const ZoneColumns<TZone, TMemSpace>& columns)
+{
+	typename ZoneColumns<TZone, TMemSpace>::HostMirror ret;
+	ret.forEachColumn(columns, [](auto& mirror, const auto& column) {
+		mirror = Kokkos::create_mirror_view(column);
+	});
+	return ret;
+}
+
+/*!
+ * @brief Gather the zones into a view of Zone
+ */
+template <typename TZone, typename TMemSpace, bool ReadOnly>
+Kokkos::View<TZone*, TMemSpace>
+makeZoneArray(const ZoneColumns<TZone, TMemSpace, ReadOnly>& columns)
+{
+	auto numZones = static_cast<IdType>(columns.size());
+	auto zones = Kokkos::View<TZone*, TMemSpace>(
+		Kokkos::ViewAllocateWithoutInitializing{columns.label()}, numZones);
+	Kokkos::parallel_for(
+		"CopyFromZoneColumns", numZones,
+		KOKKOS_LAMBDA(IdType i) { zones(i) = columns(i); });
+	Kokkos::fence();
+	return zones;
+}
+} // namespace detail
+} // namespace plsm
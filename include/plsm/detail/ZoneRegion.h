@@ -0,0 +1,324 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Kokkos_Core.hpp>
+
+#include <plsm/IntervalRange.h>
+#include <plsm/MultiIndex.h>
+#include <plsm/Utility.h>
+#include <plsm/detail/SubdivisionInfo.h>
+
+namespace plsm
+{
+namespace detail
+{
+/*!
+ * @brief Compute the region of a sub-zone of a zone with the given region
+ *
+ * @param subZoneLocalId Linear index of the sub-zone within the grid given by
+ * subdivInfo
+ */
+template <typename TRegion, DimType Dim>
+KOKKOS_INLINE_FUNCTION
+TRegion
+getSubZoneRegion(const TRegion& zoneRegion, IdType subZoneLocalId,
+	const SubdivisionInfo<Dim>& subdivInfo)
+{
+	using ScalarType = typename TRegion::ScalarType;
+	using IntervalType = typename TRegion::IntervalType;
+
+	MultiIndex<Dim> mId = subdivInfo.getMultiIndex(subZoneLocalId);
+
+	TRegion ret;
+	for (auto i : makeIntervalRange(Dim)) {
+		const auto& ival = zoneRegion[i];
+		auto delta = ival.length() / subdivInfo.getRatio()[i];
+		ret[i] =
+			IntervalType{ival.begin() + static_cast<ScalarType>(mId[i] * delta),
+				ival.begin() + static_cast<ScalarType>((mId[i] + 1) * delta)};
+	}
+	return ret;
+}
+
+/*!
+ * @brief Get the subdivision of the given (refined) zone: the SubdivisionInfo
+ * for its level, except with a ratio of 1 along any axes the refine::Detector
+ * did not enable for refinement
+ *
+ * The candidate sub-zones of the zone form the grid given by the result.
+ */
+template <typename TZones, typename TZone, DimType Dim>
+KOKKOS_INLINE_FUNCTION
+SubdivisionInfo<Dim>
+getSubZoneInfo([[maybe_unused]] const TZones& zones, const TZone& zone,
+	const SubdivisionInfo<Dim>& levelInfo)
+{
+	auto ratio = levelInfo.getRatio();
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	auto axes = zone.getSubZoneAxes();
+	for (DimType i = 0; i < Dim; ++i) {
+		if (((axes >> i) & 1u) == 0) {
+			ratio[i] = 1;
+		}
+	}
+#else
+	// The first sub-zone is as long as the zone along unsubdivided axes
+	const auto& zoneRegion = zone.getRegion();
+	auto subZoneRegion = zones(zone.getSubZoneIndices().begin()).getRegion();
+	for (DimType i = 0; i < Dim; ++i) {
+		if (subZoneRegion[i].length() == zoneRegion[i].length()) {
+			ratio[i] = 1;
+		}
+	}
+#endif
+	return SubdivisionInfo<Dim>{ratio};
+}
+
+/*!
+ * @brief Record the subdivision of the given zone (which only needs to be
+ * stored if zone regions are implicit)
+ */
+template <typename TZone, DimType Dim>
+KOKKOS_INLINE_FUNCTION
+void
+setSubZoneInfo([[maybe_unused]] TZone& zone,
+	[[maybe_unused]] const SubdivisionInfo<Dim>& subZoneInfo)
+{
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	std::uint8_t axes = 0;
+	for (DimType i = 0; i < Dim; ++i) {
+		if (subZoneInfo.getRatio()[i] > 1) {
+			axes |= static_cast<std::uint8_t>(1u << i);
+		}
+	}
+	zone.setSubZoneAxes(axes);
+#endif
+}
+
+/*!
+ * @brief Make a zone with the given region and local index (among the
+ * candidate sub-zones of its parent), keeping whichever the Zone stores
+ */
+template <typename TZone>
+KOKKOS_INLINE_FUNCTION
+TZone
+makeZone([[maybe_unused]] const typename TZone::RegionType& region,
+	[[maybe_unused]] IdType localId, std::size_t level,
+	IdType parentId = invalid<IdType>)
+{
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	return TZone{localId, level, parentId};
+#else
+	return TZone{region, level, parentId};
+#endif
+}
+
+/*!
+ * @brief Find the candidate sub-zone of the given (refined) zone which
+ * contains the given point
+ *
+ * The candidate sub-zones form a grid given by the SubdivisionInfo for the
+ * zone's level, except along any axes the refine::Detector did not enable
+ * for refinement (see getSubZoneInfo()).
+ *
+ * @param[in,out] region Region of the zone, replaced with the region of the
+ * sub-zone if zone regions are implicit (otherwise each zone has its own)
+ * @param[out] numCandidates Number of sub-zones in the grid
+ * @return Linear index of the sub-zone within the grid
+ */
+template <typename TZones, typename TZone, DimType Dim, typename TRegion,
+	typename TPoint>
+KOKKOS_INLINE_FUNCTION
+IdType
+findSubZone([[maybe_unused]] const TZones& zones, const TZone& zone,
+	const SubdivisionRatio<Dim>& levelRatio, [[maybe_unused]] TRegion& region,
+	const TPoint& point, IdType& numCandidates)
+{
+	using SizeType = typename TRegion::IntervalType::SizeType;
+	IdType localId = 0;
+	numCandidates = 1;
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	using ScalarType = typename TRegion::ScalarType;
+	auto axes = zone.getSubZoneAxes();
+	for (DimType i = 0; i < Dim; ++i) {
+		if (((axes >> i) & 1u) == 0) {
+			// Not subdivided along this axis
+			continue;
+		}
+		auto& ival = region[i];
+		auto delta = ival.length() / levelRatio[i];
+		auto offset = static_cast<SizeType>(point[i] - ival.begin());
+		auto subId = static_cast<IdType>(offset / delta);
+		localId = localId * levelRatio[i] + subId;
+		numCandidates *= levelRatio[i];
+		auto begin = ival.begin() + static_cast<ScalarType>(subId * delta);
+		ival = {begin, begin + static_cast<ScalarType>(delta)};
+	}
+#else
+	const auto& zoneRegion = zone.getRegion();
+	auto subZoneRegion = zones(zone.getSubZoneIndices().begin()).getRegion();
+	for (DimType i = 0; i < Dim; ++i) {
+		const auto& ival = zoneRegion[i];
+		auto delta = subZoneRegion[i].length();
+		if (delta == ival.length()) {
+			// Not subdivided along this axis
+			continue;
+		}
+		auto offset = static_cast<SizeType>(point[i] - ival.begin());
+		localId = localId * levelRatio[i] + static_cast<IdType>(offset / delta);
+		numCandidates *= levelRatio[i];
+	}
+#endif
+	return localId;
+}
+
+/*!
+ * @brief Get the local index of the given sub-zone among the candidate
+ * sub-zones of the given zone
+ */
+template <typename TZones, typename TZone, DimType Dim>
+KOKKOS_INLINE_FUNCTION
+IdType
+getLocalIndex([[maybe_unused]] const TZones& zones,
+	[[maybe_unused]] const TZone& zone, const TZone& subZone,
+	[[maybe_unused]] const SubdivisionRatio<Dim>& levelRatio)
+{
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	return subZone.getLocalIndex();
+#else
+	auto region = zone.getRegion();
+	IdType numCandidates = 0;
+	return findSubZone(zones, zone, levelRatio, region,
+		subZone.getRegion().getOrigin(), numCandidates);
+#endif
+}
+
+/*!
+ * @brief Get the region of the given sub-zone of the given (refined) zone
+ *
+ * @param zoneRegion Region of the zone
+ * @param levelInfo SubdivisionInfo for the zone's level
+ */
+template <typename TZones, typename TZone, typename TRegion, DimType Dim>
+KOKKOS_INLINE_FUNCTION
+TRegion
+getChildZoneRegion(const TZones& zones, [[maybe_unused]] const TZone& zone,
+	[[maybe_unused]] const TRegion& zoneRegion, IdType subZoneId,
+	[[maybe_unused]] const SubdivisionInfo<Dim>& levelInfo)
+{
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	return getSubZoneRegion(zoneRegion, zones(subZoneId).getLocalIndex(),
+		getSubZoneInfo(zones, zone, levelInfo));
+#else
+	return zones(subZoneId).getRegion();
+#endif
+}
+
+/*!
+ * @brief Get the region of the parent of the given zone
+ *
+ * If zone regions are implicit, this inverts getSubZoneRegion(), so that a
+ * walk through the tree can go back up without keeping its path.
+ *
+ * @param zoneRegion Region of the zone
+ * @param infos SubdivisionInfo for each level
+ */
+template <typename TZones, typename TZone, typename TInfos, typename TRegion>
+KOKKOS_INLINE_FUNCTION
+TRegion
+getParentZoneRegion(const TZones& zones, const TZone& zone,
+	[[maybe_unused]] const TInfos& infos,
+	[[maybe_unused]] const TRegion& zoneRegion)
+{
+	const auto& parent = zones(zone.getParentIndex());
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	using ScalarType = typename TRegion::ScalarType;
+	using IntervalType = typename TRegion::IntervalType;
+
+	auto info = getSubZoneInfo(zones, parent, infos(parent.getLevel()));
+	auto mId = info.getMultiIndex(zone.getLocalIndex());
+	TRegion ret;
+	for (DimType i = 0; i < TRegion::dimension(); ++i) {
+		auto delta = zoneRegion[i].length();
+		auto begin =
+			zoneRegion[i].begin() - static_cast<ScalarType>(mId[i] * delta);
+		ret[i] = IntervalType{
+			begin, begin + static_cast<ScalarType>(delta * info.getRatio()[i])};
+	}
+	return ret;
+#else
+	return parent.getRegion();
+#endif
+}
+
+/*!
+ * @brief Get the region of the given zone
+ *
+ * If zone regions are implicit, the region is reconstructed by following
+ * parent indices up the tree twice (rather than keeping the path): once to
+ * find how many times each axis of the root region was subdivided, which
+ * gives the size of the zone, and once to add up the offsets of the zone and
+ * of its ancestors within their parents. Where the regions of many zones are
+ * needed, it is cheaper to compute them going down the tree instead (see
+ * getSubZoneRegion()).
+ *
+ * @param infos SubdivisionInfo for each level
+ */
+template <typename TZones, typename TInfos, typename TRegion>
+KOKKOS_INLINE_FUNCTION
+TRegion
+getZoneRegion(const TZones& zones, [[maybe_unused]] const TInfos& infos,
+	[[maybe_unused]] const TRegion& rootRegion, IdType zoneId)
+{
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	using ScalarType = typename TRegion::ScalarType;
+	using IntervalType = typename TRegion::IntervalType;
+	using SizeType = typename IntervalType::SizeType;
+	constexpr auto dim = TRegion::dimension();
+
+	SizeType divisions[dim];
+	for (DimType i = 0; i < dim; ++i) {
+		divisions[i] = 1;
+	}
+	for (auto id = zoneId; zones(id).hasParent();) {
+		id = zones(id).getParentIndex();
+		const auto& parent = zones(id);
+		auto info = getSubZoneInfo(zones, parent, infos(parent.getLevel()));
+		for (DimType i = 0; i < dim; ++i) {
+			divisions[i] *= static_cast<SizeType>(info.getRatio()[i]);
+		}
+	}
+
+	TRegion ret;
+	SizeType offsets[dim];
+	for (DimType i = 0; i < dim; ++i) {
+		auto size = rootRegion[i].length() / divisions[i];
+		ret[i] = IntervalType{rootRegion[i].begin(),
+			rootRegion[i].begin() + static_cast<ScalarType>(size)};
+		offsets[i] = 0;
+	}
+	for (auto id = zoneId; zones(id).hasParent();) {
+		const auto& zone = zones(id);
+		id = zone.getParentIndex();
+		const auto& parent = zones(id);
+		auto info = getSubZoneInfo(zones, parent, infos(parent.getLevel()));
+		auto mId = info.getMultiIndex(zone.getLocalIndex());
+		for (DimType i = 0; i < dim; ++i) {
+			// Zones at this level are a fraction 1 / divisions of the root
+			offsets[i] += static_cast<SizeType>(mId[i]) *
+				(rootRegion[i].length() / divisions[i]);
+			divisions[i] /= static_cast<SizeType>(info.getRatio()[i]);
+		}
+	}
+	for (DimType i = 0; i < dim; ++i) {
+		auto offset = static_cast<ScalarType>(offsets[i]);
+		ret[i] = IntervalType{ret[i].begin() + offset, ret[i].end() + offset};
+	}
+	return ret;
+#else
+	return zones(zoneId).getRegion();
+#endif
+}
+} // namespace detail
+} // namespace plsm
@@ -11,8 +11,8 @@ namespace plsm
 namespace refine
 {
 /*!
- * BallDetector is a Detector implementing intersect() and overlap() with
- * respect to a hyperball
+ * BallDetector is a Detector implementing intersect(), overlap(), and
+ * classify() with respect to a hyperball
  *
  * @test unittest_Detectors
  * @test benchmark_Subpaving.cpp
@@ -99,6 +99,8 @@ public:
 		return false;
 	}
 
+	using Superclass::overlap;
+
 	/*!
 	 * @brief Test for if the given Region either intersects or is contained by
 	 * the hyperball
@@ -134,6 +136,66 @@ public:
 		return (d <= _radSq);
 	}
 
+	/*!
+	 * @brief Classify the given Region with respect to the hyperball
+	 *
+	 * The Region is inside if even its farthest corner is strictly within the
+	 * radius, and outside if its nearest point is beyond the radius.
+	 */
+	KOKKOS_INLINE_FUNCTION
+	Classification
+	classify(const RegionType& region) const
+	{
+		constexpr ScalarDiff zero = 0;
+		ScalarType d_min = 0;
+		ScalarType d_max = 0;
+		for (DimType i = 0; i < Dim; ++i) {
+			auto c_i = static_cast<ScalarDiff>(_center[i]);
+			auto e_lo = c_i - static_cast<ScalarDiff>(region[i].begin());
+			auto e_hi = c_i - static_cast<ScalarDiff>(region[i].end());
+			if (e_lo < zero) {
+				if (e_lo < -static_cast<ScalarDiff>(_radius)) {
+					return Classification::outside;
+				}
+				d_min += static_cast<ScalarType>(e_lo * e_lo);
+				d_max += static_cast<ScalarType>(e_hi * e_hi);
+			}
+			else if (e_hi > zero) {
+				if (e_hi > static_cast<ScalarDiff>(_radius)) {
+					return Classification::outside;
+				}
+				d_min += static_cast<ScalarType>(e_hi * e_hi);
+				d_max += static_cast<ScalarType>(e_lo * e_lo);
+			}
+			else {
+				auto r =
+					static_cast<ScalarType>(plsm::max(e_lo, plsm::abs(e_hi)));
+				d_max += r * r;
+			}
+		}
+		if (d_min > _radSq) {
+			return Classification::outside;
+		}
+		if (d_max < _radSq) {
+			return Classification::inside;
+		}
+		return Classification::boundary;
+	}
+
+	/*!
+	 * @brief Hash the center and radius (see Detector::hash())
+	 */
+	std::uint64_t
+	hash() const
+	{
+		using ::plsm::detail::hashCombine;
+		auto ret = this->makeHash("BallDetector");
+		for (DimType i = 0; i < Dim; ++i) {
+			ret = hashCombine(ret, _center[i]);
+		}
+		return hashCombine(ret, _radius);
+	}
+
 private:
 	//! Ball center point
 	PointType _center{};
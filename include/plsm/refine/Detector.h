@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
+
 #include <Kokkos_Macros.hpp>
 
 #include <plsm/Utility.h>
+#include <plsm/detail/Hash.h>
 
 namespace plsm
 {
@@ -51,6 +54,19 @@ struct SelectAll
 {
 };
 
+/*!
+ * @brief Classification of a Region with respect to the geometry of a Detector
+ *
+ * A definite classification (inside or outside) must also hold for every
+ * subregion of the classified Region.
+ */
+enum class Classification
+{
+	outside, /*!< Entirely outside the geometry */
+	boundary, /*!< Possibly crossing the boundary; must be tested */
+	inside /*!< Entirely inside the geometry */
+};
+
 /*!
  * @relates Detector
  * Pair of tag types for refinement and selection; for use as template argument
@@ -130,6 +146,103 @@ struct RefineTraits<::plsm::refine::Overlap>
 	//! Select
 	using SelectTag = ::plsm::refine::Select;
 };
+
+/*!
+ * @brief Get the decision implied by a Classification for the given tag
+ *
+ * By default nothing is implied (for example, Refine and Select are entirely
+ * up to the derived detector).
+ *
+ * @param[out] result The implied decision, if there is one
+ * @return true if the decision is implied, false if it must be tested
+ */
+template <typename TTag>
+KOKKOS_INLINE_FUNCTION
+bool
+getImpliedDecision(TTag, Classification, bool&) noexcept
+{
+	return false;
+}
+
+/*!
+ * @brief A Region entirely inside or outside does not intersect the boundary
+ * @copydetails getImpliedDecision()
+ */
+KOKKOS_INLINE_FUNCTION
+bool
+getImpliedDecision(
+	::plsm::refine::Intersect, Classification cls, bool& result) noexcept
+{
+	if (cls == Classification::boundary) {
+		return false;
+	}
+	result = false;
+	return true;
+}
+
+/*!
+ * @brief A Region entirely inside overlaps; one entirely outside does not
+ * @copydetails getImpliedDecision()
+ */
+KOKKOS_INLINE_FUNCTION
+bool
+getImpliedDecision(
+	::plsm::refine::Overlap, Classification cls, bool& result) noexcept
+{
+	if (cls == Classification::boundary) {
+		return false;
+	}
+	result = (cls == Classification::inside);
+	return true;
+}
+
+/*!
+ * @brief SelectAll is always true
+ * @copydetails getImpliedDecision()
+ */
+KOKKOS_INLINE_FUNCTION
+bool
+getImpliedDecision(
+	::plsm::refine::SelectAll, Classification, bool& result) noexcept
+{
+	result = true;
+	return true;
+}
+
+/*!
+ * @brief Get a stable name for each tag (for hashing)
+ */
+//!@{
+constexpr const char*
+getTagName(::plsm::refine::Refine) noexcept
+{
+	return "Refine";
+}
+
+constexpr const char*
+getTagName(::plsm::refine::Intersect) noexcept
+{
+	return "Intersect";
+}
+
+constexpr const char*
+getTagName(::plsm::refine::Overlap) noexcept
+{
+	return "Overlap";
+}
+
+constexpr const char*
+getTagName(::plsm::refine::Select) noexcept
+{
+	return "Select";
+}
+
+constexpr const char*
+getTagName(::plsm::refine::SelectAll) noexcept
+{
+	return "SelectAll";
+}
+//!@}
 } // namespace detail
 
 /*!
@@ -183,6 +296,10 @@ public:
 	//! Special value to specify no level limit on refinement
 	static constexpr std::size_t fullDepth = wildcard<std::size_t>;
 
+	//! Special value returned by hash() for a detector which cannot be
+	//! identified by its parameters
+	static constexpr std::uint64_t noHash = 0;
+
 	/*!
 	 * @brief Default constructor uses fullDepth
 	 */
@@ -288,6 +405,56 @@ public:
 		return true;
 	}
 
+	/*!
+	 * @brief Classify the given Region as entirely inside, entirely outside,
+	 * or on the boundary of the detector geometry
+	 *
+	 * Derived classes may implement this to let the detail::Refiner skip
+	 * decisions for whole subtrees: once a Region is classified inside or
+	 * outside, the decisions for its descendants are taken from the
+	 * classification (see detail::getImpliedDecision()) without calling the
+	 * detector again. This default cannot tell, so it always returns
+	 * Classification::boundary.
+	 */
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	Classification
+	classify(const TRegion&) const noexcept
+	{
+		return Classification::boundary;
+	}
+
+	/*!
+	 * @brief Get the priority for refining the given Region within a
+	 * RefinementBudget (higher is refined first)
+	 *
+	 * Derived classes may implement this with an error estimate, so that a
+	 * limited budget is spent where refinement matters most. This default
+	 * gives the volume, so that larger regions are refined first and the
+	 * refinement proceeds breadth-first.
+	 */
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	double
+	priority(const TRegion& region) const noexcept
+	{
+		return region.volume();
+	}
+
+	/*!
+	 * @brief Get a hash of the detector type and parameters
+	 *
+	 * The hash is stable across runs, so that it can identify the result of
+	 * refining with the detector (see RefinementCache). Derived classes may
+	 * implement this, starting from makeHash(). This default returns noHash,
+	 * meaning the detector cannot be identified.
+	 */
+	std::uint64_t
+	hash() const
+	{
+		return noHash;
+	}
+
 	/*!
 	 * @brief Set each element of the given BoolVec with the single given value
 	 * @param[in] value Boolean result to apply
@@ -341,6 +508,20 @@ public:
 	}
 
 protected:
+	/*!
+	 * @brief Start a hash (see hash()) for the derived class with the given
+	 * name, including the tags and the refinement depth
+	 */
+	std::uint64_t
+	makeHash(const char* name) const
+	{
+		using ::plsm::detail::hashCombine;
+		auto ret = hashCombine(::plsm::detail::hashSeed, name);
+		ret = hashCombine(ret, detail::getTagName(refineTag));
+		ret = hashCombine(ret, detail::getTagName(selectTag));
+		return hashCombine(ret, static_cast<std::uint64_t>(_depth));
+	}
+
 	/*!
 	 * @brief static_cast to TDerived
 	 */
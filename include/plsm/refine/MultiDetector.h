@@ -1,5 +1,7 @@
 #pragma once
 
+#include <limits>
+
 #include <plsm/refine/Detector.h>
 
 namespace plsm
@@ -44,6 +46,28 @@ public:
 	{
 		return true;
 	}
+
+	/*!
+	 * @brief Default priority implementation
+	 * @return Lowest value as starting point for the maximum
+	 */
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	double
+	priority(const TRegion&) const
+	{
+		return -std::numeric_limits<double>::max();
+	}
+
+	/*!
+	 * @brief Default hash implementation
+	 * @return The given hash, as the end of the chain
+	 */
+	std::uint64_t
+	hash(std::uint64_t seed) const
+	{
+		return seed;
+	}
 };
 
 /*!
@@ -109,6 +133,38 @@ public:
 		return retHead && retTail;
 	}
 
+	/*!
+	 * @brief Take the highest priority along the chain among the detectors
+	 * which would refine the region
+	 */
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	double
+	priority(const TRegion& region) const
+	{
+		BoolVec<TRegion> resHead;
+		auto retTail = Tail::priority(region);
+		if (!_detector(Head::refineTag, region, resHead)) {
+			return retTail;
+		}
+		auto retHead = _detector.priority(region);
+		return (retHead > retTail) ? retHead : retTail;
+	}
+
+	/*!
+	 * @brief Combine the hashes along the chain (noHash if any detector has
+	 * none)
+	 */
+	std::uint64_t
+	hash(std::uint64_t seed) const
+	{
+		auto headHash = _detector.hash();
+		if (headHash == Head::noHash) {
+			return Head::noHash;
+		}
+		return Tail::hash(::plsm::detail::hashCombine(seed, headHash));
+	}
+
 private:
 	//! My detector
 	Head _detector;
@@ -167,6 +223,28 @@ public:
 		return _impl.select(region);
 	}
 
+	/*!
+	 * @brief Take the highest priority among the detectors which would
+	 * refine the given Region
+	 */
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	double
+	priority(const TRegion& region) const
+	{
+		return _impl.priority(region);
+	}
+
+	/*!
+	 * @brief Combine the hashes of all detectors (see Detector::hash()); the
+	 * result is noHash if any of them has none
+	 */
+	std::uint64_t
+	hash() const
+	{
+		return _impl.hash(this->makeHash("MultiDetector"));
+	}
+
 private:
 	//! Implementation
 	detail::MultiDetectorImpl<TDetectors...> _impl;
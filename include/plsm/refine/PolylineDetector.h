@@ -107,6 +107,25 @@ public:
 		return false;
 	}
 
+	/*!
+	 * @brief Hash the polyline points (see Detector::hash())
+	 */
+	std::uint64_t
+	hash() const
+	{
+		using ::plsm::detail::hashCombine;
+		auto ret = this->makeHash("PolylineDetector");
+		auto fMirror = Kokkos::create_mirror_view(_flats);
+		Kokkos::deep_copy(fMirror, _flats);
+		for (std::size_t f = 0; f < fMirror.size(); ++f) {
+			auto point = fMirror[f].expand();
+			for (DimType i = 0; i < Dim; ++i) {
+				ret = hashCombine(ret, point[i]);
+			}
+		}
+		return ret;
+	}
+
 private:
 	//! poly-hyperplane representation in terms of CompactFlat objects
 	Kokkos::View<FlatType*> _flats;
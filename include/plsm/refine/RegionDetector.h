@@ -8,8 +8,8 @@ namespace plsm
 namespace refine
 {
 /*!
- * RegionDetector is a Detector implementing intersect() and overlap() with
- * respect to a Region
+ * RegionDetector is a Detector implementing intersect(), overlap(), and
+ * classify() with respect to a Region
  *
  * @test unittest_Detectors
  * @test unittest_Subpaving.cpp
@@ -75,6 +75,47 @@ public:
 		return _region.intersects(region);
 	}
 
+	/*!
+	 * @brief Classify the given Region with respect to the reference Region
+	 *
+	 * The Region is inside if it is contained in the reference Region without
+	 * being considered to intersect its boundary, and outside if the two do
+	 * not overlap.
+	 */
+	KOKKOS_INLINE_FUNCTION
+	Classification
+	classify(const RegionType& region) const
+	{
+		if (!overlap(region)) {
+			return Classification::outside;
+		}
+		for (DimType i = 0; i < region.dimension(); ++i) {
+			if (region[i].begin() < _region[i].begin() ||
+				region[i].end() > _region[i].end()) {
+				return Classification::boundary;
+			}
+		}
+		if (intersect(region)) {
+			return Classification::boundary;
+		}
+		return Classification::inside;
+	}
+
+	/*!
+	 * @brief Hash the reference region (see Detector::hash())
+	 */
+	std::uint64_t
+	hash() const
+	{
+		using ::plsm::detail::hashCombine;
+		auto ret = this->makeHash("RegionDetector");
+		for (DimType i = 0; i < Dim; ++i) {
+			ret = hashCombine(ret, _region[i].begin());
+			ret = hashCombine(ret, _region[i].end());
+		}
+		return ret;
+	}
+
 private:
 	//! Alias for Region Interval
 	using IntervalType = typename RegionType::IntervalType;
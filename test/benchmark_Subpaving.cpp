@@ -2,6 +2,7 @@
 
 #include <exception>
 #include <iostream>
+#include <string>
 
 #include <plsm/RenderSubpaving.h>
 #include <plsm/Subpaving.h>
@@ -79,11 +80,10 @@ TEST_CASE("Subpaving 3D", "[Subpaving]")
 		std::size_t errors = 0;
 		BENCHMARK("search: ball")
 		{
-			auto tiles = s.getTiles();
 			Kokkos::parallel_reduce(
-				tiles.size(),
-				KOKKOS_LAMBDA(std::size_t i, std::size_t & running) {
-					auto id = s.findTileId(tiles[i].getRegion().getOrigin());
+				s.getNumberOfTiles(),
+				KOKKOS_LAMBDA(IdType i, std::size_t & running) {
+					auto id = s.findTileId(s.getTileRegion(i).getOrigin());
 					if (id != i) {
 						++running;
 					}
@@ -128,11 +128,10 @@ TEST_CASE("Subpaving 3D", "[Subpaving]")
 		std::size_t errors = 0;
 		BENCHMARK("search: z-aligned polyline plus box")
 		{
-			auto tiles = s.getTiles();
 			Kokkos::parallel_reduce(
-				tiles.size(),
-				KOKKOS_LAMBDA(std::size_t i, std::size_t & running) {
-					auto id = s.findTileId(tiles[i].getRegion().getOrigin());
+				s.getNumberOfTiles(),
+				KOKKOS_LAMBDA(IdType i, std::size_t & running) {
+					auto id = s.findTileId(s.getTileRegion(i).getOrigin());
 					if (id != i) {
 						++running;
 					}
@@ -227,11 +226,10 @@ TEST_CASE("Subpaving with XRN Defaults", "[Subpaving][XRN]")
 	std::size_t errors = 0;
 	BENCHMARK("search: XRN")
 	{
-		auto tiles = s.getTiles();
 		Kokkos::parallel_reduce(
-			tiles.size(),
-			KOKKOS_LAMBDA(std::size_t i, std::size_t & running) {
-				auto id = s.findTileId(tiles[i].getRegion().getOrigin());
+			s.getNumberOfTiles(),
+			KOKKOS_LAMBDA(IdType i, std::size_t & running) {
+				auto id = s.findTileId(s.getTileRegion(i).getOrigin());
 				if (id != i) {
 					++running;
 				}
@@ -239,4 +237,110 @@ TEST_CASE("Subpaving with XRN Defaults", "[Subpaving][XRN]")
 			errors);
 	};
 	REQUIRE(errors == 0);
+
+	// Query the tile origins in a scattered order
+	using PointType = typename Subpaving<int, 3>::PointType;
+	auto numTiles = s.getNumberOfTiles();
+	Kokkos::View<PointType*> points("Points", numTiles);
+	Kokkos::parallel_for(
+		numTiles, KOKKOS_LAMBDA(IdType i) {
+			auto j = static_cast<IdType>(std::uint64_t{i} * 7919 % numTiles);
+			points(j) = s.getTileRegion(i).getOrigin();
+		});
+	Kokkos::View<IdType*, DefaultMemSpace> tileIds;
+	IdType notFound = 0;
+	BENCHMARK("search (batched): XRN")
+	{
+		notFound = s.findTileIds(points, tileIds, false);
+	};
+	REQUIRE(notFound == 0);
+	BENCHMARK("search (batched, sorted): XRN")
+	{
+		notFound = s.findTileIds(points, tileIds);
+	};
+	REQUIRE(notFound == 0);
+
+	// Tiles within a window, by scanning the tiles and by searching the zones
+	RegionType window{{Ival{900, 1100}, Ival{400, 600}, Ival{0, 16}}};
+	IdType numScanned = 0;
+	BENCHMARK("range query (scan): XRN")
+	{
+		Kokkos::parallel_reduce(
+			numTiles,
+			KOKKOS_LAMBDA(IdType i, IdType & running) {
+				if (s.getTileRegion(i).intersects(window)) {
+					++running;
+				}
+			},
+			numScanned);
+	};
+	IdType numFound = 0;
+	BENCHMARK("range query: XRN")
+	{
+		numFound = s.findTilesIntersecting(window, tileIds);
+	};
+	REQUIRE(numFound == numScanned);
+
+	Subpaving<int, 3>::TileAdjacencyType adjacency;
+	BENCHMARK("face neighbors: XRN")
+	{
+		s.findFaceNeighbors(adjacency);
+	};
+	REQUIRE(adjacency.getNumberOfTiles() == numTiles);
+
+	// Best-first refinement within half of the tiles
+	RefinementBudget budget;
+	budget.maxTiles = numTiles / 2;
+	budget.batchSize = 1 << 16;
+	IdType numBudgetTiles = 0;
+	BENCHMARK("refine (budget): XRN")
+	{
+		Subpaving<int, 3> b(r, {{{10, 8, 2}}, {{2, 2, 2}}});
+		b.refine(refine::PolylineDetector<int, 3>{rspecPoints}, budget);
+		numBudgetTiles = b.getNumberOfTiles();
+	};
+	REQUIRE(numBudgetTiles <= budget.maxTiles);
+}
+
+TEST_CASE("Subpaving Zone Layout", "[Subpaving][ZoneLayout]")
+{
+	// Run once with and once without PLSM_USE_SOA_ZONES to compare layouts
+#if defined(PLSM_USE_SOA_ZONES)
+	const std::string layout = " (SoA zones)";
+#else
+	const std::string layout = " (AoS zones)";
+#endif
+	using RegionType = typename Subpaving<int, 3>::RegionType;
+	using Ival = Interval<int>;
+	RegionType r{{Ival{0, 512}, Ival{0, 512}, Ival{0, 512}}};
+	Subpaving<int, 3> s(r, {{{2, 2, 2}}});
+	BENCHMARK("refine: ball" + layout)
+	{
+		using Tags = refine::TagPair<refine::Intersect, refine::Overlap>;
+		s.refine(refine::BallDetector<int, 3, Tags>{{256, 256, 256}, 128});
+	};
+
+	std::size_t errors = 0;
+	BENCHMARK("search: ball" + layout)
+	{
+		Kokkos::parallel_reduce(
+			s.getNumberOfTiles(),
+			KOKKOS_LAMBDA(IdType i, std::size_t & running) {
+				auto id = s.findTileId(s.getTileRegion(i).getOrigin());
+				if (id != i) {
+					++running;
+				}
+			},
+			errors);
+	};
+	REQUIRE(errors == 0);
+
+	RegionType window{{Ival{200, 312}, Ival{200, 312}, Ival{0, 512}}};
+	Kokkos::View<IdType*, DefaultMemSpace> tileIds;
+	IdType numFound = 0;
+	BENCHMARK("range query: ball" + layout)
+	{
+		numFound = s.findTilesIntersecting(window, tileIds);
+	};
+	REQUIRE(numFound > 0);
 }
@@ -18,7 +18,8 @@ printSubpaving(TSubpaving& subpaving, std::ostream& os)
 	os << "Zones: " << zones.size() << '\n';
 	for (std::size_t i = 0; i < zones.size(); ++i) {
 		const auto& zone = zones(i);
-		os << i << ": reg " << zone.getRegion() << "; subs "
+		os << i << ": reg "
+		   << subpaving.getZoneRegion(static_cast<IdType>(i)) << "; subs "
 		   << zone.getSubZoneIndices();
 		if (zone.hasParent()) {
 			os << "; parent " << zone.getParentIndex();
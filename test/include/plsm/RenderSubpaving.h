@@ -23,14 +23,13 @@ inline void
 renderSubpaving(Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>& sp)
 {
 	auto subpaving = sp.makeMirrorCopy();
-	auto tiles = subpaving.getTiles();
 
-	auto numTiles = tiles.extent(0);
+	auto numTiles = subpaving.getNumberOfTiles();
 	auto points = vtkSmartPointer<vtkPoints>::New();
 	auto cells = vtkSmartPointer<vtkCellArray>::New();
 	vtkIdType pId = 0;
 	for (std::size_t i = 0; i < numTiles; ++i) {
-		const auto& region = tiles(i).getRegion();
+		auto region = subpaving.getTileRegion(i);
 
 		if (Dim == 3) {
 			points->InsertNextPoint(
@@ -172,10 +171,9 @@ template <typename TScalar, std::size_t Dim, typename TEnum, typename TItemData,
 inline void
 plot(Subpaving<TScalar, Dim, TEnum, TItemData, TMemSpace>& subpaving)
 {
-	auto tiles = subpaving.getTiles();
 	std::ofstream ofs("gp.txt");
-	for (auto i : makeIntervalRange(tiles.extent(0))) {
-		const auto& region = tiles(i).getRegion();
+	for (auto i : makeIntervalRange(subpaving.getNumberOfTiles())) {
+		auto region = subpaving.getTileRegion(i);
 		ofs << "\n";
 		ofs << region[0].begin() << " " << region[1].begin() << "\n";
 		ofs << region[0].end() << " " << region[1].begin() << "\n";
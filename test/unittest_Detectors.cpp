@@ -1,5 +1,6 @@
 #include <catch.hpp>
 
+#include <limits>
 #include <type_traits>
 
 #include <plsm/Region.h>
@@ -32,6 +33,16 @@ TEMPLATE_LIST_TEST_CASE(
 	REQUIRE(rd2.overlap(r));
 
 	// TODO: Need to test intersect
+
+	using refine::Classification;
+	REQUIRE(rd2.classify(r) == Classification::boundary);
+	REQUIRE(rd2.classify({{Ival{40, 50}, Ival{40, 50}}}) ==
+		Classification::inside);
+	REQUIRE(rd2.classify({{Ival{16}, Ival{16}}}) == Classification::outside);
+	REQUIRE(rd2.classify({{Ival{90, 96}, Ival{40, 50}}}) ==
+		Classification::boundary);
+	REQUIRE(rd2.classify({{Ival{16, 48}, Ival{40, 50}}}) ==
+		Classification::boundary);
 }
 
 TEMPLATE_LIST_TEST_CASE(
@@ -272,6 +283,29 @@ TEMPLATE_LIST_TEST_CASE(
 		REQUIRE(bd2(selectTag, r9));
 		REQUIRE(bd2(selectTag, r10));
 	}
+
+	SECTION("Classification")
+	{
+		using refine::Classification;
+		refine::BallDetector<TestType, 2> bd2{{64, 64}, 64};
+		REQUIRE(bd2.classify(r) == Classification::boundary);
+		REQUIRE(bd2.classify(r1) == Classification::boundary);
+		REQUIRE(bd2.classify(r2) == Classification::boundary);
+		REQUIRE(bd2.classify(r3) == Classification::boundary);
+		REQUIRE(bd2.classify(r4) == Classification::boundary);
+		REQUIRE(bd2.classify(r5) == Classification::inside);
+		REQUIRE(bd2.classify(r7) == Classification::outside);
+		REQUIRE(bd2.classify(r8) == Classification::outside);
+		REQUIRE(bd2.classify(r9) == Classification::outside);
+		REQUIRE(bd2.classify(r10) == Classification::outside);
+		for (auto reg : {r, r1, r2, r3, r4, r5, r7, r8, r9, r10}) {
+			auto cls = bd2.classify(reg);
+			if (cls != Classification::boundary) {
+				REQUIRE(!bd2.intersect(reg));
+				REQUIRE(bd2.overlap(reg) == (cls == Classification::inside));
+			}
+		}
+	}
 }
 
 TEMPLATE_LIST_TEST_CASE(
@@ -418,4 +452,41 @@ TEMPLATE_LIST_TEST_CASE(
 		},
 		failLine);
 	REQUIRE(failLine == 0);
+
+	// The priority is the highest among the detectors which would refine
+	REQUIRE(md.priority(r1) == r1.volume());
+	REQUIRE(md.priority(r3) == -std::numeric_limits<double>::max());
+}
+
+TEMPLATE_LIST_TEST_CASE(
+	"Detector Hashes", "[Detectors][template]", test::IntTypes)
+{
+	using namespace refine;
+	using BD = BallDetector<TestType, 2>;
+	using RD = RegionDetector<TestType, 2>;
+	using PD = PolylineDetector<TestType, 2>;
+
+	REQUIRE(BD{{64, 64}, 64}.hash() == BD{{64, 64}, 64}.hash());
+	REQUIRE(BD{{64, 64}, 64}.hash() != BD{{64, 64}, 32}.hash());
+	REQUIRE(BD{{64, 64}, 64}.hash() != BD{{64, 32}, 64}.hash());
+	REQUIRE(BD{{64, 64}, 64, 2}.hash() != BD{{64, 64}, 64, 3}.hash());
+	REQUIRE(BD{{64, 64}, 64}.hash() != BD::noHash);
+
+	REQUIRE(RD{{{32, 96}, {32, 96}}}.hash() == RD{{{32, 96}, {32, 96}}}.hash());
+	REQUIRE(RD{{{32, 96}, {32, 96}}}.hash() != RD{{{32, 96}, {0, 96}}}.hash());
+
+	PD pd{{{{0, 0}}, {{256, 128}}, {{512, 512}}}};
+	REQUIRE(pd.hash() == PD{{{{0, 0}}, {{256, 128}}, {{512, 512}}}}.hash());
+	REQUIRE(pd.hash() != PD{{{{0, 0}}, {{256, 128}}, {{512, 256}}}}.hash());
+
+	// Different detector types with the same parameters differ
+	using TD = RegionDetector<TestType, 2, TagPair<Overlap, SelectAll>>;
+	REQUIRE(RD{{{32, 96}, {32, 96}}}.hash() != TD{{{32, 96}, {32, 96}}}.hash());
+
+	auto md = makeMultiDetector(BD{{64, 64}, 64}, RD{{{32, 96}, {32, 96}}});
+	REQUIRE(md.hash() ==
+		makeMultiDetector(BD{{64, 64}, 64}, RD{{{32, 96}, {32, 96}}}).hash());
+	REQUIRE(md.hash() !=
+		makeMultiDetector(BD{{64, 64}, 32}, RD{{{32, 96}, {32, 96}}}).hash());
+	REQUIRE(md.hash() != MultiDetector<BD, RD>::noHash);
 }
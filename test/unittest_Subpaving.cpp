@@ -1,12 +1,21 @@
 #include <catch.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
 #include <exception>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <plsm/PrintSubpaving.h>
 #include <plsm/RenderSubpaving.h>
 #include <plsm/Subpaving.h>
 #include <plsm/TestingCommon.h>
+#include <plsm/refine/BallDetector.h>
 #include <plsm/refine/RegionDetector.h>
 using namespace plsm;
 
@@ -46,6 +55,143 @@ makeSubpavingTester(const TSubpaving& subpaving)
 {
 	return SubpavingTester<TSubpaving>{subpaving};
 }
+
+/*!
+ * Forwards refine and select decisions to a wrapped detector while hiding its
+ * classify(), so that every decision is made by calling the detector, and
+ * counts the select calls
+ */
+template <typename TDetector>
+class UnclassifiedDetector :
+	public refine::Detector<UnclassifiedDetector<TDetector>,
+		refine::TagPair<refine::Refine, refine::Select>>
+{
+public:
+	using Superclass = refine::Detector<UnclassifiedDetector<TDetector>,
+		refine::TagPair<refine::Refine, refine::Select>>;
+
+	explicit UnclassifiedDetector(const TDetector& detector) :
+		Superclass(detector.depth()),
+		_detector{detector},
+		_selectCalls("Select Calls", 1)
+	{
+	}
+
+	IdType
+	getSelectCalls() const
+	{
+		auto selectCalls = create_mirror_view(_selectCalls);
+		deep_copy(selectCalls, _selectCalls);
+		return selectCalls(0);
+	}
+
+	using Superclass::refine;
+
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	bool
+	refine(const TRegion& region) const
+	{
+		return _detector(_detector.refineTag, region);
+	}
+
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	bool
+	select(const TRegion& region) const
+	{
+		Kokkos::atomic_add(&_selectCalls(0), IdType{1});
+		return _detector(_detector.selectTag, region);
+	}
+
+private:
+	TDetector _detector;
+	Kokkos::View<IdType*> _selectCalls;
+};
+
+/*!
+ * Refines every region along the first axis only, except for regions at the
+ * beginning of the first axis, which are refined along every axis
+ */
+class FirstAxisDetector :
+	public refine::Detector<FirstAxisDetector,
+		refine::TagPair<refine::Refine, refine::SelectAll>>
+{
+public:
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	bool
+	refine(const TRegion&) const
+	{
+		return true;
+	}
+
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	bool
+	refine(const TRegion& region, refine::BoolVec<TRegion>& result) const
+	{
+		for (DimType i = 0; i < result.size(); ++i) {
+			result[i] = (i == 0) || (region[0].begin() == 0);
+		}
+		return true;
+	}
+};
+
+/*!
+ * Refines every region, giving the highest priority to those nearest the
+ * origin of the lattice
+ */
+class OriginPriorityDetector :
+	public refine::Detector<OriginPriorityDetector,
+		refine::TagPair<refine::Refine, refine::SelectAll>>
+{
+public:
+	using Superclass = refine::Detector<OriginPriorityDetector,
+		refine::TagPair<refine::Refine, refine::SelectAll>>;
+
+	using Superclass::refine;
+
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	bool
+	refine(const TRegion&) const
+	{
+		return true;
+	}
+
+	template <typename TRegion>
+	KOKKOS_INLINE_FUNCTION
+	double
+	priority(const TRegion& region) const
+	{
+		return -static_cast<double>(region[0].begin() + region[1].begin());
+	}
+};
+
+/*!
+ * Item data other than an index, for a subpaving to carry with its tiles
+ */
+struct TileValue
+{
+	double value;
+	IdType count;
+};
+
+/*!
+ * Copy the regions of the tiles of the given subpaving to the host
+ */
+template <typename TSubpaving>
+std::vector<typename TSubpaving::RegionType>
+getTileRegions(const TSubpaving& subpaving)
+{
+	auto sph = subpaving.makeMirrorCopy();
+	std::vector<typename TSubpaving::RegionType> ret(sph.getNumberOfTiles());
+	for (IdType i = 0; i < ret.size(); ++i) {
+		ret[i] = sph.getTileRegion(i);
+	}
+	return ret;
+}
 } // namespace plsm::test
 
 TEMPLATE_LIST_TEST_CASE(
@@ -108,6 +254,13 @@ TEMPLATE_LIST_TEST_CASE(
 	REQUIRE(test::makeSubpavingTester(sp).checkRatios(
 		{{{4, 4, 2, 2}, {4, 4, 2, 2}, {4, 4, 2, 2}, {4, 4, 2, 2}, {1, 1, 2, 2},
 			{1, 1, 2, 2}, {1, 1, 1, 2}}}));
+
+#if defined(PLSM_USE_PACKED_ZONES)
+	// Too many sub-zones per zone for a packed zone
+	REQUIRE_THROWS_AS((Subpaving<TestType, 2>({{{0, 512}, {0, 512}}},
+						  {{{512, 512}}})),
+		std::invalid_argument);
+#endif
 }
 
 TEMPLATE_LIST_TEST_CASE(
@@ -131,8 +284,6 @@ TEMPLATE_LIST_TEST_CASE(
 
 		using Range3D = Kokkos::MDRangePolicy<Kokkos::Rank<3>>;
 		std::size_t errors = 0;
-		auto tiles = sp.getTiles();
-
 		Kokkos::parallel_reduce(
 			Range3D({0, 0, 0}, {4, 4, 4}),
 			KOKKOS_LAMBDA(
@@ -152,7 +303,31 @@ TEMPLATE_LIST_TEST_CASE(
 				TestType i, TestType j, TestType k, std::size_t & running) {
 				PointType p({i, j, k});
 				auto tileId = sp.findTileId(p);
-				if (tiles(tileId).getRegion().getOrigin() != p) {
+				if (sp.getTileRegion(tileId).getOrigin() != p) {
+					++running;
+				}
+			},
+			errors);
+		REQUIRE(errors == 0);
+	}
+
+	SECTION("Successive Refinement")
+	{
+		using RegionDetector = refine::RegionDetector<TestType, 3,
+			refine::TagPair<refine::Overlap, refine::SelectAll>>;
+		sp.refine(RegionDetector{sp.getLatticeRegion(), 1});
+		REQUIRE(sp.getTiles().extent(0) == 8);
+
+		// Only the corner tile keeps being refined
+		sp.refine(RegionDetector{{Ival{0, 1}, Ival{0, 1}, Ival{0, 1}}});
+		REQUIRE(sp.getTiles().extent(0) == 15);
+
+		std::size_t errors = 0;
+		Kokkos::parallel_reduce(
+			sp.getNumberOfTiles(),
+			KOKKOS_LAMBDA(IdType i, std::size_t & running) {
+				auto id = sp.findTileId(sp.getTileRegion(i).getOrigin());
+				if (id != i) {
 					++running;
 				}
 			},
@@ -160,3 +335,1310 @@ TEMPLATE_LIST_TEST_CASE(
 		REQUIRE(errors == 0);
 	}
 }
+
+TEMPLATE_LIST_TEST_CASE(
+	"Subpaving Refinement", "[Subpaving][template]", test::IntTypes)
+{
+	using SubpavingType = Subpaving<TestType, 2>;
+	using RegionType = typename SubpavingType::RegionType;
+	using Ival = typename RegionType::IntervalType;
+	using RegionDetector = refine::RegionDetector<TestType, 2,
+		refine::TagPair<refine::Overlap, refine::SelectAll>>;
+	SubpavingType sp({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+
+	SECTION("Ratio Growing With Level")
+	{
+		sp.refine(RegionDetector{sp.getLatticeRegion(), 1});
+		REQUIRE(sp.getNumberOfTiles() == 4);
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		REQUIRE(sp.getNumberOfTiles() == 64);
+		REQUIRE(sp.getZones().extent(0) == 69);
+	}
+
+	SECTION("Partial Selection")
+	{
+		using SelectDetector = refine::RegionDetector<TestType, 2,
+			refine::TagPair<refine::Overlap, refine::Overlap>>;
+		sp.refine(SelectDetector{{Ival{0, 3}, Ival{0, 3}}});
+		// First quadrant is split into 16 of which 9 are kept
+		REQUIRE(sp.getNumberOfTiles() == 9);
+		auto sph = sp.makeMirrorCopy();
+		REQUIRE(sph.findTileId({2, 2}) != invalid<IdType>);
+		REQUIRE(sph.findTileId({3, 3}) == invalid<IdType>);
+		REQUIRE(sph.findTileId({6, 6}) == invalid<IdType>);
+
+		// Compare direct lookup against the region of each tile
+		IdType errors = 0;
+		for (TestType i = 0; i < 8; ++i) {
+			for (TestType j = 0; j < 8; ++j) {
+				auto tileId = sph.findTileId({i, j});
+				if (i < 3 && j < 3) {
+					if (tileId == invalid<IdType> ||
+						!sph.getTileRegion(tileId).contains({i, j})) {
+						++errors;
+					}
+				}
+				else if (tileId != invalid<IdType>) {
+					++errors;
+				}
+			}
+		}
+		REQUIRE(errors == 0);
+
+		// Batched lookup, with and without sorting, matches single lookup
+		using PointType = typename SubpavingType::PointType;
+		using MemorySpace = typename SubpavingType::MemorySpace;
+		Kokkos::View<PointType*, MemorySpace> points("Points", 64);
+		auto pointsMirror = create_mirror_view(points);
+		for (TestType i = 0; i < 8; ++i) {
+			for (TestType j = 0; j < 8; ++j) {
+				// Visit in an order unrelated to the lattice
+				auto k = static_cast<IdType>((i * 8 + j) * 5 % 64);
+				pointsMirror(k) = {i, j};
+			}
+		}
+		deep_copy(points, pointsMirror);
+		for (bool sortPoints : {false, true}) {
+			Kokkos::View<IdType*, MemorySpace> tileIds;
+			REQUIRE(sp.findTileIds(points, tileIds, sortPoints) == 55);
+			REQUIRE(tileIds.extent(0) == 64);
+			auto tileIdsMirror = create_mirror_view(tileIds);
+			deep_copy(tileIdsMirror, tileIds);
+			errors = 0;
+			for (IdType k = 0; k < 64; ++k) {
+				if (tileIdsMirror(k) != sph.findTileId(pointsMirror(k))) {
+					++errors;
+				}
+			}
+			REQUIRE(errors == 0);
+		}
+	}
+
+	SECTION("Prolongation")
+	{
+		using MemorySpace = typename SubpavingType::MemorySpace;
+
+		// Nothing refined: the initial tile is its own parent
+		Prolongation<MemorySpace> identity;
+		sp.refine(RegionDetector{{Ival{16, 24}, Ival{16, 24}}}, identity);
+		REQUIRE(sp.getNumberOfTiles() == 1);
+		REQUIRE(identity.getNumberOfTiles() == 1);
+		auto identityIds = create_mirror_view(identity.getParentTileIds());
+		deep_copy(identityIds, identity.getParentTileIds());
+		auto identityWeights = create_mirror_view(identity.getWeights());
+		deep_copy(identityWeights, identity.getWeights());
+		REQUIRE(identityIds(0) == 0);
+		REQUIRE(identityWeights(0) == Approx(1.0));
+
+		sp.refine(RegionDetector{sp.getLatticeRegion(), 1});
+		REQUIRE(sp.getNumberOfTiles() == 4);
+		auto coarseRegions = test::getTileRegions(sp);
+
+		Prolongation<MemorySpace> prolongation;
+		sp.refine(RegionDetector{sp.getLatticeRegion()}, prolongation);
+		REQUIRE(sp.getNumberOfTiles() == 64);
+		REQUIRE(prolongation.getNumberOfTiles() == 64);
+
+		// Each tile comes from the coarse tile containing it
+		auto regions = test::getTileRegions(sp);
+		auto parentTileIds =
+			create_mirror_view(prolongation.getParentTileIds());
+		deep_copy(parentTileIds, prolongation.getParentTileIds());
+		IdType errors = 0;
+		for (IdType i = 0; i < regions.size(); ++i) {
+			auto parentId = parentTileIds(i);
+			if (parentId >= coarseRegions.size() ||
+				!coarseRegions[parentId].contains(regions[i].getOrigin())) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+
+		// Transferred quantities are conserved
+		Kokkos::View<double*, MemorySpace> coarseData("Coarse Data", 4);
+		Kokkos::View<double*, MemorySpace> fineData;
+		Kokkos::parallel_for(
+			4, KOKKOS_LAMBDA(IdType i) {
+				coarseData(i) = 16.0 * static_cast<double>(i + 1);
+			});
+		prolongation.apply(coarseData, fineData);
+		REQUIRE(fineData.extent(0) == 64);
+		auto fineDataMirror = create_mirror_view(fineData);
+		deep_copy(fineDataMirror, fineData);
+		double coarseSums[4]{};
+		for (IdType i = 0; i < 64; ++i) {
+			coarseSums[parentTileIds(i)] += fineDataMirror(i);
+		}
+		for (int i = 0; i < 4; ++i) {
+			REQUIRE(coarseSums[i] == Approx(16.0 * (i + 1)));
+		}
+
+		Kokkos::View<double**, MemorySpace> coarseComponents(
+			"Coarse Components", 4, 2);
+		Kokkos::View<double**, MemorySpace> fineComponents;
+		Kokkos::deep_copy(coarseComponents, 32.0);
+		prolongation.apply(coarseComponents, fineComponents);
+		REQUIRE(fineComponents.extent(0) == 64);
+		REQUIRE(fineComponents.extent(1) == 2);
+		auto fineComponentsMirror = create_mirror_view(fineComponents);
+		deep_copy(fineComponentsMirror, fineComponents);
+		REQUIRE(fineComponentsMirror(63, 1) == Approx(2.0));
+	}
+
+	SECTION("Coarsening")
+	{
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		REQUIRE(sp.getNumberOfTiles() == 64);
+		auto fineRegions = test::getTileRegions(sp);
+
+		// Keep only the first quadrant refined
+		auto tileMap = sp.coarsen(RegionDetector{{Ival{0, 4}, Ival{0, 4}}});
+		REQUIRE(sp.getNumberOfTiles() == 19);
+		REQUIRE(sp.getZones().extent(0) == 21);
+		REQUIRE(tileMap.extent(0) == 64);
+		auto sph = sp.makeMirrorCopy();
+		auto tiles = sph.getTiles();
+		auto zones = sph.getZones();
+		auto tileMapMirror = create_mirror_view(tileMap);
+		deep_copy(tileMapMirror, tileMap);
+		IdType errors = 0;
+		for (IdType i = 0; i < fineRegions.size(); ++i) {
+			auto origin = fineRegions[i].getOrigin();
+			auto tileId = sph.findTileId(origin);
+			if (tileId != tileMapMirror(i) ||
+				!sph.getTileRegion(tileId).contains(origin)) {
+				++errors;
+			}
+		}
+		for (IdType i = 0; i < tiles.extent(0); ++i) {
+			if (zones(tiles(i).getOwningZoneIndex()).getTileIndex() != i) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+
+		// Nothing left to refine
+		tileMap = sp.coarsen(RegionDetector{sp.getLatticeRegion(), 0});
+		REQUIRE(sp.getNumberOfTiles() == 1);
+		REQUIRE(sp.getZones().extent(0) == 1);
+		REQUIRE(sp.getRefinementDepth() == 0);
+		tileMapMirror = create_mirror_view(tileMap);
+		deep_copy(tileMapMirror, tileMap);
+		for (IdType i = 0; i < tileMapMirror.extent(0); ++i) {
+			if (tileMapMirror(i) != 0) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+
+		// The coarsened subpaving can be refined again
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		REQUIRE(sp.getNumberOfTiles() == 64);
+	}
+
+	SECTION("Tile Reordering")
+	{
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		auto oldRegions = test::getTileRegions(sp);
+
+		auto checkTiles = [&](const auto& order) {
+			auto sph = sp.makeMirrorCopy();
+			auto tiles = sph.getTiles();
+			auto zones = sph.getZones();
+			auto orderMirror = create_mirror_view(order);
+			deep_copy(orderMirror, order);
+			IdType errors = 0;
+			for (IdType i = 0; i < tiles.extent(0); ++i) {
+				auto region = sph.getTileRegion(i);
+				if (region != oldRegions[orderMirror(i)] ||
+					zones(tiles(i).getOwningZoneIndex()).getTileIndex() != i ||
+					sph.findTileId(region.getOrigin()) != i) {
+					++errors;
+				}
+			}
+			return errors;
+		};
+
+		// Morton order of the unit tiles interleaves the bits of the
+		// coordinates (with the first axis most significant)
+		auto order = sp.reorderTiles(SpaceFillingCurve::morton);
+		REQUIRE(order.extent(0) == 64);
+		REQUIRE(checkTiles(order) == 0);
+		auto regions = test::getTileRegions(sp);
+		IdType errors = 0;
+		for (IdType i = 0; i < regions.size(); ++i) {
+			TestType x = 0;
+			TestType y = 0;
+			for (unsigned b = 0; b < 3; ++b) {
+				x |= static_cast<TestType>(((i >> (2 * b + 1)) & 1) << b);
+				y |= static_cast<TestType>(((i >> (2 * b)) & 1) << b);
+			}
+			auto origin = regions[i].getOrigin();
+			if (origin[0] != x || origin[1] != y) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+
+		// Consecutive tiles in Hilbert order are adjacent
+		oldRegions = regions;
+		order = sp.reorderTiles(SpaceFillingCurve::hilbert);
+		REQUIRE(checkTiles(order) == 0);
+		regions = test::getTileRegions(sp);
+		for (IdType i = 1; i < regions.size(); ++i) {
+			auto a = regions[i - 1].getOrigin();
+			auto b = regions[i].getOrigin();
+			auto dx = (a[0] > b[0]) ? a[0] - b[0] : b[0] - a[0];
+			auto dy = (a[1] > b[1]) ? a[1] - b[1] : b[1] - a[1];
+			if (dx + dy != 1) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+	}
+
+	SECTION("Save and Load")
+	{
+		sp.refine(RegionDetector{{Ival{0, 4}, Ival{0, 4}}});
+		auto path = (std::filesystem::temp_directory_path() /
+			"plsm_unittest_subpaving.bin")
+						.string();
+		sp.save(path);
+
+		auto checkSame = [&](const auto& other) {
+			auto sph = sp.makeMirrorCopy();
+			auto oth = other.makeMirrorCopy();
+			REQUIRE(oth.getLatticeRegion() == sph.getLatticeRegion());
+			REQUIRE(oth.getRefinementDepth() == sph.getRefinementDepth());
+			REQUIRE(oth.getZones().extent(0) == sph.getZones().extent(0));
+			REQUIRE(oth.getTiles().extent(0) == sph.getTiles().extent(0));
+			IdType errors = 0;
+			for (IdType i = 0; i < sph.getZones().extent(0); ++i) {
+				const auto& a = sph.getZones()(i);
+				const auto& b = oth.getZones()(i);
+				if (sph.getZoneRegion(i) != oth.getZoneRegion(i) ||
+					a.getTileIndex() != b.getTileIndex() ||
+					a.getParentIndex() != b.getParentIndex()) {
+					++errors;
+				}
+			}
+			auto tiles = sph.getTiles();
+			for (IdType i = 0; i < tiles.extent(0); ++i) {
+				auto region = sph.getTileRegion(i);
+				if (region != oth.getTileRegion(i) ||
+					oth.findTileId(region.getOrigin()) != i) {
+					++errors;
+				}
+			}
+			REQUIRE(errors == 0);
+		};
+
+		SubpavingType loaded;
+		loaded.load(path);
+		checkSame(loaded);
+
+		{
+			typename SubpavingType::HostMirror mapped;
+			MappedFile file(path);
+			mapped.load(file);
+			checkSame(mapped);
+		}
+
+		// Files for other subpaving types are rejected
+		Subpaving<TestType, 3> other;
+		REQUIRE_THROWS_AS(other.load(path), std::runtime_error);
+		std::remove(path.c_str());
+		REQUIRE_THROWS_AS(loaded.load(path), std::runtime_error);
+	}
+
+	SECTION("Refinement Cache")
+	{
+		auto dir = std::filesystem::temp_directory_path() /
+			"plsm_unittest_refinement_cache";
+		std::filesystem::remove_all(dir);
+		RefinementCache cache{dir};
+		REQUIRE(std::filesystem::is_directory(cache.getDirectory()));
+
+		auto detector = RegionDetector{{Ival{0, 4}, Ival{0, 4}}};
+		auto report = sp.refine(detector, cache);
+		REQUIRE(!report.loadedFromCache);
+		REQUIRE(report.levels.size() == 2);
+		auto numEntries = [&dir] {
+			return std::distance(std::filesystem::directory_iterator{dir},
+				std::filesystem::directory_iterator{});
+		};
+		// A result and its report
+		REQUIRE(numEntries() == 2);
+
+		// The same refinement of the same subpaving is loaded, with its report
+		SubpavingType other({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		report = other.refine(detector, cache);
+		REQUIRE(report.loadedFromCache);
+		REQUIRE(report.levels.size() == 2);
+		REQUIRE(report.getTilesCreated() == sp.getNumberOfTiles() - 1);
+		REQUIRE(other.getNumberOfTiles() == sp.getNumberOfTiles());
+		REQUIRE(test::getTileRegions(other) == test::getTileRegions(sp));
+
+		// Along with a workspace, or a prolongation
+		other = SubpavingType({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		RefinementWorkspace<2> workspace;
+		report = other.refine(detector, cache, workspace);
+		REQUIRE(report.loadedFromCache);
+		REQUIRE(test::getTileRegions(other) == test::getTileRegions(sp));
+		other = SubpavingType({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		Prolongation<typename SubpavingType::MemorySpace> prolongation;
+		report = other.refine(detector, cache, prolongation);
+		REQUIRE(report.loadedFromCache);
+		REQUIRE(prolongation.getNumberOfTiles() == sp.getNumberOfTiles());
+		auto parentTileIds =
+			create_mirror_view(prolongation.getParentTileIds());
+		deep_copy(parentTileIds, prolongation.getParentTileIds());
+		for (IdType i = 0; i < parentTileIds.extent(0); ++i) {
+			REQUIRE(parentTileIds(i) == 0);
+		}
+
+		// A different detector, or a different starting state, is not
+		other = SubpavingType({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		report = other.refine(RegionDetector{{Ival{0, 2}, Ival{0, 2}}}, cache);
+		REQUIRE(!report.loadedFromCache);
+		report = sp.refine(detector, cache);
+		REQUIRE(!report.loadedFromCache);
+		REQUIRE(numEntries() == 6);
+
+		// Detectors without a hash are never cached
+		auto unhashed = test::UnclassifiedDetector<RegionDetector>{detector};
+		REQUIRE(unhashed.hash() == decltype(unhashed)::noHash);
+		other = SubpavingType({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		report = other.refine(unhashed, cache);
+		REQUIRE(!report.loadedFromCache);
+		REQUIRE(numEntries() == 6);
+
+		// Floating-point item data is hashed by value
+		using DoubleSubpaving = Subpaving<TestType, 2, void, double>;
+		DoubleSubpaving dsp0({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		DoubleSubpaving dsp1({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		Kokkos::deep_copy(dsp0.getItemData(), 0.5);
+		Kokkos::deep_copy(dsp1.getItemData(), 0.5);
+		REQUIRE(!dsp0.refine(detector, cache).loadedFromCache);
+		REQUIRE(dsp1.refine(detector, cache).loadedFromCache);
+		REQUIRE(test::getTileRegions(dsp1) == test::getTileRegions(dsp0));
+		DoubleSubpaving dsp2({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		Kokkos::deep_copy(dsp2.getItemData(), 0.25);
+		REQUIRE(!dsp2.refine(detector, cache).loadedFromCache);
+
+		// Item data without an ItemDataHash cannot be cached
+		using ValueSubpaving = Subpaving<TestType, 2, void, test::TileValue>;
+		ValueSubpaving vsp({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		REQUIRE_THROWS_AS(
+			vsp.refine(detector, cache), std::invalid_argument);
+
+		std::filesystem::remove_all(dir);
+	}
+
+	SECTION("Capacity")
+	{
+		sp.reserve(10, 20);
+		REQUIRE(sp.getZoneCapacity() == 10);
+		REQUIRE(sp.getTileCapacity() == 20);
+		REQUIRE(sp.getZones().extent(0) == 1);
+		REQUIRE(sp.getNumberOfTiles() == 1);
+
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		REQUIRE(sp.getNumberOfTiles() == 64);
+		REQUIRE(sp.getZones().extent(0) == 69);
+		REQUIRE(sp.getZoneCapacity() >= 69);
+		REQUIRE(sp.getTileCapacity() >= 64);
+
+		auto memSize = sp.getDeviceMemorySize();
+		sp.shrinkToFit();
+		REQUIRE(sp.getZoneCapacity() == 69);
+		REQUIRE(sp.getTileCapacity() == 64);
+		REQUIRE(sp.getDeviceMemorySize() <= memSize);
+
+		auto sph = sp.makeMirrorCopy();
+		auto tiles = sph.getTiles();
+		IdType errors = 0;
+		for (IdType i = 0; i < tiles.extent(0); ++i) {
+			auto origin = sph.getTileRegion(i).getOrigin();
+			if (sph.findTileId(origin) != i) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+	}
+
+	SECTION("Workspace")
+	{
+		typename SubpavingType::RefinementWorkspaceType workspace;
+		REQUIRE(workspace.getDeviceMemorySize() == 0);
+
+		SubpavingType other({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		other.refine(RegionDetector{sp.getLatticeRegion()});
+
+		sp.refine(RegionDetector{sp.getLatticeRegion(), 1}, workspace);
+		REQUIRE(sp.getNumberOfTiles() == 4);
+		auto memSize = workspace.getDeviceMemorySize();
+		REQUIRE(memSize > 0);
+		sp.refine(RegionDetector{sp.getLatticeRegion()}, workspace);
+		REQUIRE(sp.getNumberOfTiles() == 64);
+		REQUIRE(workspace.getDeviceMemorySize() >= memSize);
+
+		// Refining again needs no more space
+		memSize = workspace.getDeviceMemorySize();
+		auto capacity = workspace.getCapacity();
+		sp.refine(RegionDetector{sp.getLatticeRegion()}, workspace);
+		REQUIRE(workspace.getDeviceMemorySize() == memSize);
+		REQUIRE(workspace.getCapacity() == capacity);
+
+		// Using the workspace does not change the result
+		REQUIRE(test::getTileRegions(sp) == test::getTileRegions(other));
+
+		workspace.clear();
+		REQUIRE(workspace.getDeviceMemorySize() == 0);
+	}
+
+	SECTION("Report")
+	{
+		auto detector = test::UnclassifiedDetector<RegionDetector>{
+			RegionDetector{sp.getLatticeRegion()}};
+		auto report = sp.refine(detector);
+		REQUIRE(report.levels.size() == 2);
+
+		const auto& first = report.levels[0];
+		REQUIRE(first.level == 0);
+		REQUIRE(first.tilesExamined == 1);
+		REQUIRE(first.refineCalls == 1);
+		// Each selection is evaluated once, when counting
+		REQUIRE(first.selectCalls == 4);
+		REQUIRE(first.zonesCreated == 4);
+		REQUIRE(first.tilesCreated == 3);
+		REQUIRE(first.scratchBytesAllocated > 0);
+
+		const auto& second = report.levels[1];
+		REQUIRE(second.level == 1);
+		REQUIRE(second.tilesExamined == 4);
+		REQUIRE(second.refineCalls == 4);
+		REQUIRE(second.selectCalls == 64);
+		REQUIRE(second.zonesCreated == 64);
+		REQUIRE(second.tilesCreated == 60);
+
+		REQUIRE(report.getZonesCreated() == 68);
+		REQUIRE(report.getTilesCreated() == 63);
+		REQUIRE(report.getTotalTime() >= 0.0);
+		REQUIRE(report.getDeviceMemoryHighWater() >= sp.getDeviceMemorySize());
+
+		// Nothing left to refine
+		report = sp.refine(detector);
+		REQUIRE(report.levels.size() == 1);
+		REQUIRE(report.levels[0].tilesExamined == 64);
+		REQUIRE(report.levels[0].zonesCreated == 0);
+	}
+
+	SECTION("Classification")
+	{
+		using BallDetector = refine::BallDetector<TestType, 2,
+			refine::TagPair<refine::Overlap, refine::Overlap>>;
+		BallDetector ball{{32, 32}, 20};
+		RegionType latticeRegion{{Ival{0, 64}, Ival{0, 64}}};
+		std::vector<SubdivisionRatio<2>> ratios{{2, 2}, {2, 2}, {4, 4}};
+		SubpavingType sp0(latticeRegion, ratios);
+		SubpavingType sp1(latticeRegion, ratios);
+		// Classified tiles pass their results down instead of asking again
+		sp0.refine(ball);
+		sp1.refine(test::UnclassifiedDetector<BallDetector>{ball});
+		REQUIRE(test::getTileRegions(sp0) == test::getTileRegions(sp1));
+	}
+	SECTION("Team Selection")
+	{
+		using BallDetector = refine::BallDetector<TestType, 2,
+			refine::TagPair<refine::Overlap, refine::Overlap>>;
+		BallDetector ball{{32, 32}, 20};
+		RegionType latticeRegion{{Ival{0, 64}, Ival{0, 64}}};
+		// Ratio products large enough for a team to select each tile's
+		// sub-zones
+		std::vector<SubdivisionRatio<2>> ratios{{8, 8}, {8, 8}};
+		REQUIRE(ratios[0].getProduct() >=
+			detail::Refiner<SubpavingType,
+				BallDetector>::teamSelectionThreshold);
+		SubpavingType sp0(latticeRegion, ratios);
+		SubpavingType sp1(latticeRegion, ratios);
+		sp0.refine(ball);
+		auto unclassified = test::UnclassifiedDetector<BallDetector>{ball};
+		auto report = sp1.refine(unclassified);
+		REQUIRE(report.levels.size() == 2);
+		REQUIRE(report.levels[0].selectCalls == 128);
+
+		// Each candidate sub-zone is evaluated once when counting and once
+		// when filling, as reported
+		IdType selectCalls = 0;
+		for (const auto& level : report.levels) {
+			selectCalls += level.selectCalls;
+		}
+		REQUIRE(unclassified.getSelectCalls() == selectCalls);
+
+		// The result is exactly the unit cells overlapping the ball
+		IdType numCells = 0;
+		for (TestType i = 0; i < 64; ++i) {
+			for (TestType j = 0; j < 64; ++j) {
+				if (ball(ball.selectTag,
+						RegionType{{Ival{i, i + 1}, Ival{j, j + 1}}})) {
+					++numCells;
+				}
+			}
+		}
+		IdType errors = 0;
+		for (auto& subpaving : {sp0, sp1}) {
+			auto sph = subpaving.makeMirrorCopy();
+			auto tiles = sph.getTiles();
+			REQUIRE(tiles.extent(0) == numCells);
+			for (IdType i = 0; i < tiles.extent(0); ++i) {
+				auto region = sph.getTileRegion(i);
+				if (region.volume() != 1 || !ball(ball.selectTag, region) ||
+					sph.findTileId(region.getOrigin()) != i) {
+					++errors;
+				}
+			}
+		}
+		REQUIRE(errors == 0);
+	}
+
+	SECTION("Zone Regions")
+	{
+		// Each zone lies within its parent, and the tiles cover the lattice
+		auto checkRegions = [&sp]() {
+			auto sph = sp.makeMirrorCopy();
+			auto zones = sph.getZones();
+			IdType errors = 0;
+			for (IdType i = 1; i < zones.extent(0); ++i) {
+				auto region = sph.getZoneRegion(i);
+				auto parentRegion =
+					sph.getZoneRegion(zones(i).getParentIndex());
+				for (DimType d = 0; d < 2; ++d) {
+					if (region[d].empty() ||
+						region[d].begin() < parentRegion[d].begin() ||
+						region[d].end() > parentRegion[d].end()) {
+						++errors;
+					}
+				}
+			}
+			std::size_t volume = 0;
+			for (IdType i = 0; i < sph.getNumberOfTiles(); ++i) {
+				auto region = sph.getTileRegion(i);
+				volume += static_cast<std::size_t>(region.volume());
+				if (sph.findTileId(region.getOrigin()) != i) {
+					++errors;
+				}
+			}
+			REQUIRE(volume == 64);
+			return errors;
+		};
+
+		// Sub-zones which only subdivide some axes
+		sp.refine(test::FirstAxisDetector{});
+		REQUIRE(checkRegions() == 0);
+		auto sph = sp.makeMirrorCopy();
+		IdType errors = 0;
+		for (IdType i = 0; i < sph.getNumberOfTiles(); ++i) {
+			auto region = sph.getTileRegion(i);
+			if (region[0].length() != 1 ||
+				(region[0].begin() == 0 && region[1].length() != 1)) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+		REQUIRE(sph.getNumberOfTiles() < 64);
+
+		sp.coarsen(RegionDetector{{Ival{0, 4}, Ival{0, 4}}});
+		REQUIRE(checkRegions() == 0);
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		REQUIRE(checkRegions() == 0);
+		REQUIRE(sp.getNumberOfTiles() == 64);
+	}
+
+	SECTION("Range Query")
+	{
+		using MemorySpace = typename SubpavingType::MemorySpace;
+		std::vector<RegionType> queries{{{Ival{0, 8}, Ival{0, 8}}},
+			{{Ival{0, 1}, Ival{0, 1}}}, {{Ival{3, 5}, Ival{2, 7}}},
+			{{Ival{7, 8}, Ival{0, 8}}}, {{Ival{2, 6}, Ival{5, 6}}},
+			{{Ival{8, 9}, Ival{0, 8}}}};
+
+		// Compare each kind of query against a scan of the tiles
+		auto checkQueries = [&sp, &queries]() {
+			auto sph = sp.makeMirrorCopy();
+			auto numQueries = static_cast<IdType>(queries.size());
+			auto regions = Kokkos::View<RegionType*, MemorySpace>(
+				"Query Regions", numQueries);
+			auto regionsMirror = create_mirror_view(regions);
+			std::vector<std::vector<IdType>> expected(queries.size());
+			for (IdType q = 0; q < numQueries; ++q) {
+				regionsMirror(q) = queries[q];
+				for (IdType i = 0; i < sph.getNumberOfTiles(); ++i) {
+					if (sph.getTileRegion(i).intersects(queries[q])) {
+						expected[q].push_back(i);
+					}
+				}
+			}
+			deep_copy(regions, regionsMirror);
+
+			IdType errors = 0;
+			for (IdType q = 0; q < numQueries; ++q) {
+				auto numExpected = static_cast<IdType>(expected[q].size());
+				REQUIRE(sp.findTilesIntersecting(queries[q]) == numExpected);
+				REQUIRE(sph.countTilesIntersecting(queries[q]) == numExpected);
+				Kokkos::View<IdType*, MemorySpace> tileIds;
+				REQUIRE(sp.findTilesIntersecting(queries[q], tileIds) ==
+					numExpected);
+				REQUIRE(tileIds.extent(0) == expected[q].size());
+				auto tileIdsMirror = create_mirror_view(tileIds);
+				deep_copy(tileIdsMirror, tileIds);
+				std::vector<IdType> found(
+					tileIdsMirror.data(), tileIdsMirror.data() + numExpected);
+				std::sort(found.begin(), found.end());
+				if (found != expected[q]) {
+					++errors;
+				}
+			}
+
+			Kokkos::View<IdType*, MemorySpace> offsets;
+			Kokkos::View<IdType*, MemorySpace> tileIds;
+			auto numFound = sp.findTilesIntersecting(regions, offsets, tileIds);
+			REQUIRE(offsets.extent(0) == queries.size() + 1);
+			REQUIRE(tileIds.extent(0) == numFound);
+			auto offsetsMirror = create_mirror_view(offsets);
+			deep_copy(offsetsMirror, offsets);
+			auto tileIdsMirror = create_mirror_view(tileIds);
+			deep_copy(tileIdsMirror, tileIds);
+			REQUIRE(offsetsMirror(numQueries) == numFound);
+			for (IdType q = 0; q < numQueries; ++q) {
+				auto begin = tileIdsMirror.data();
+				std::vector<IdType> found(
+					begin + offsetsMirror(q), begin + offsetsMirror(q + 1));
+				std::sort(found.begin(), found.end());
+				if (found != expected[q]) {
+					++errors;
+				}
+			}
+			return errors;
+		};
+
+		REQUIRE(checkQueries() == 0);
+		using SelectDetector = refine::RegionDetector<TestType, 2,
+			refine::TagPair<refine::Overlap, refine::Overlap>>;
+		sp.refine(SelectDetector{{Ival{0, 3}, Ival{0, 3}}});
+		REQUIRE(checkQueries() == 0);
+		sp.refine(RegionDetector{sp.getLatticeRegion(), 1});
+		REQUIRE(checkQueries() == 0);
+
+		// Sub-zones which only subdivide some axes
+		sp = SubpavingType({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		sp.refine(test::FirstAxisDetector{});
+		REQUIRE(checkQueries() == 0);
+		sp.coarsen(RegionDetector{{Ival{0, 4}, Ival{0, 4}}});
+		REQUIRE(checkQueries() == 0);
+	}
+
+	SECTION("Sum Overlaps")
+	{
+		using MemorySpace = typename SubpavingType::MemorySpace;
+		using BallDetector = refine::BallDetector<TestType, 2,
+			refine::TagPair<refine::Overlap, refine::Overlap>>;
+		REQUIRE(getSumRegion(RegionType{{Ival{1, 3}, Ival{0, 4}}},
+					RegionType{{Ival{2, 3}, Ival{4, 8}}}) ==
+			RegionType{{Ival{3, 5}, Ival{4, 11}}});
+		REQUIRE(getOverlapVolume(RegionType{{Ival{1, 3}, Ival{0, 4}}},
+					RegionType{{Ival{2, 5}, Ival{1, 8}}}) == 3.0);
+		REQUIRE(getOverlapVolume(RegionType{{Ival{1, 3}, Ival{0, 4}}},
+					RegionType{{Ival{3, 5}, Ival{1, 8}}}) == 0.0);
+		IdType pairIndex = 0;
+		for (IdType a = 0; a < 5; ++a) {
+			for (IdType b = a; b < 5; ++b) {
+				auto pair = getTilePair(5, pairIndex++);
+				REQUIRE(pair.first == a);
+				REQUIRE(pair.second == b);
+			}
+		}
+
+		// Compare the overlaps for the pairs accepted by a predicate against
+		// a scan of the tiles
+		auto checkOverlaps = [&sp]() {
+			typename SubpavingType::SumOverlapsType overlaps;
+			sp.findSumOverlaps(
+				KOKKOS_LAMBDA(IdType a, IdType b) { return (a + b) % 3 == 0; },
+				overlaps);
+			auto regions = test::getTileRegions(sp);
+			auto numTiles = static_cast<IdType>(regions.size());
+			REQUIRE(overlaps.getOffsets().extent(0) ==
+				overlaps.getNumberOfPairs() + 1);
+			auto firstMirror = create_mirror_view(overlaps.getFirstTileIds());
+			deep_copy(firstMirror, overlaps.getFirstTileIds());
+			auto secondMirror = create_mirror_view(overlaps.getSecondTileIds());
+			deep_copy(secondMirror, overlaps.getSecondTileIds());
+			auto offsetsMirror = create_mirror_view(overlaps.getOffsets());
+			deep_copy(offsetsMirror, overlaps.getOffsets());
+			auto tileIdsMirror = create_mirror_view(overlaps.getTileIds());
+			deep_copy(tileIdsMirror, overlaps.getTileIds());
+			auto volumesMirror =
+				create_mirror_view(overlaps.getOverlapVolumes());
+			deep_copy(volumesMirror, overlaps.getOverlapVolumes());
+
+			IdType errors = 0;
+			IdType p = 0;
+			for (IdType a = 0; a < numTiles; ++a) {
+				for (IdType b = a; b < numTiles; ++b) {
+					if ((a + b) % 3 != 0) {
+						continue;
+					}
+					REQUIRE(p < overlaps.getNumberOfPairs());
+					if (firstMirror(p) != a || secondMirror(p) != b) {
+						++errors;
+					}
+					auto sumRegion = getSumRegion(regions[a], regions[b]);
+					std::vector<std::pair<IdType, double>> expected;
+					for (IdType c = 0; c < numTiles; ++c) {
+						if (regions[c].intersects(sumRegion)) {
+							expected.emplace_back(
+								c, getOverlapVolume(regions[c], sumRegion));
+						}
+					}
+					std::vector<std::pair<IdType, double>> found;
+					for (auto k = offsetsMirror(p); k < offsetsMirror(p + 1);
+						 ++k) {
+						found.emplace_back(tileIdsMirror(k), volumesMirror(k));
+					}
+					std::sort(found.begin(), found.end());
+					if (found != expected) {
+						++errors;
+					}
+					++p;
+				}
+			}
+			REQUIRE(p == overlaps.getNumberOfPairs());
+			REQUIRE(offsetsMirror(p) == overlaps.getNumberOfOverlaps());
+			return errors;
+		};
+
+		REQUIRE(checkOverlaps() == 0);
+		sp.refine(BallDetector{{4, 4}, 3});
+		REQUIRE(checkOverlaps() == 0);
+		sp.refine(test::FirstAxisDetector{});
+		REQUIRE(checkOverlaps() == 0);
+
+		// The predicate is called once for each pair
+		Kokkos::View<IdType*, MemorySpace> calls("Predicate Calls", 1);
+		typename SubpavingType::SumOverlapsType overlaps;
+		sp.findSumOverlaps(
+			KOKKOS_LAMBDA(IdType, IdType) {
+				Kokkos::atomic_add(&calls(0), IdType{1});
+				return false;
+			},
+			overlaps);
+		auto callsMirror = create_mirror_view(calls);
+		deep_copy(callsMirror, calls);
+		auto numTiles = sp.getNumberOfTiles();
+		REQUIRE(callsMirror(0) == numTiles * (numTiles + 1) / 2);
+		REQUIRE(overlaps.getNumberOfPairs() == 0);
+
+		Kokkos::View<IdType*, MemorySpace> firstTileIds("First Tile Ids", 2);
+		Kokkos::View<IdType*, MemorySpace> secondTileIds("Second Tile Ids", 3);
+		REQUIRE_THROWS_AS(
+			sp.findSumOverlaps(firstTileIds, secondTileIds, overlaps),
+			std::invalid_argument);
+	}
+
+	SECTION("Face Neighbors")
+	{
+		using BallDetector = refine::BallDetector<TestType, 2,
+			refine::TagPair<refine::Overlap, refine::Overlap>>;
+
+		// Compare the graph against a check of each pair of tiles
+		auto checkAdjacency = [&sp]() {
+			typename SubpavingType::TileAdjacencyType adjacency;
+			sp.findFaceNeighbors(adjacency);
+			auto regions = test::getTileRegions(sp);
+			auto numTiles = static_cast<IdType>(regions.size());
+			REQUIRE(adjacency.getNumberOfTiles() == numTiles);
+			auto rowMapMirror = create_mirror_view(adjacency.getRowMap());
+			deep_copy(rowMapMirror, adjacency.getRowMap());
+			auto entriesMirror = create_mirror_view(adjacency.getEntries());
+			deep_copy(entriesMirror, adjacency.getEntries());
+			auto areasMirror = create_mirror_view(adjacency.getFaceAreas());
+			deep_copy(areasMirror, adjacency.getFaceAreas());
+			REQUIRE(rowMapMirror(numTiles) == adjacency.getNumberOfEdges());
+
+			IdType errors = 0;
+			for (IdType a = 0; a < numTiles; ++a) {
+				std::vector<std::pair<IdType, double>> expected;
+				for (IdType b = 0; b < numTiles; ++b) {
+					// Touching along one axis and overlapping along the other
+					const auto& ra = regions[a];
+					const auto& rb = regions[b];
+					for (DimType d = 0; d < 2; ++d) {
+						auto o = 1 - d;
+						if ((ra[d].end() == rb[d].begin() ||
+								rb[d].end() == ra[d].begin()) &&
+							ra[o].intersects(rb[o])) {
+							auto begin = std::max(ra[o].begin(), rb[o].begin());
+							auto end = std::min(ra[o].end(), rb[o].end());
+							expected.emplace_back(b, (double)(end - begin));
+						}
+					}
+				}
+				std::sort(expected.begin(), expected.end());
+				std::vector<std::pair<IdType, double>> found;
+				for (auto k = rowMapMirror(a); k < rowMapMirror(a + 1); ++k) {
+					found.emplace_back(entriesMirror(k), areasMirror(k));
+				}
+				std::sort(found.begin(), found.end());
+				if (found != expected) {
+					++errors;
+				}
+			}
+			return errors;
+		};
+
+		REQUIRE(checkAdjacency() == 0);
+		sp.refine(RegionDetector{sp.getLatticeRegion(), 1});
+		REQUIRE(checkAdjacency() == 0);
+		sp.refine(BallDetector{{4, 4}, 3});
+		REQUIRE(checkAdjacency() == 0);
+		sp.refine(test::FirstAxisDetector{});
+		REQUIRE(checkAdjacency() == 0);
+
+		// A uniform grid of 8 x 8 tiles has 2 * 8 * 7 shared faces
+		sp = SubpavingType({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		typename SubpavingType::TileAdjacencyType adjacency;
+		sp.findFaceNeighbors(adjacency);
+		REQUIRE(adjacency.getNumberOfEdges() == 2 * 2 * 8 * 7);
+	}
+
+	SECTION("Level Balance")
+	{
+		// Largest level difference between tiles sharing a face
+		auto getMaxLevelDifference = [](const SubpavingType& subpaving) {
+			typename SubpavingType::TileAdjacencyType adjacency;
+			subpaving.findFaceNeighbors(adjacency);
+			auto sph = subpaving.makeMirrorCopy();
+			auto rowMap = create_mirror_view(adjacency.getRowMap());
+			deep_copy(rowMap, adjacency.getRowMap());
+			auto entries = create_mirror_view(adjacency.getEntries());
+			deep_copy(entries, adjacency.getEntries());
+			auto getLevel = [&sph](IdType tileId) {
+				auto zoneId = sph.getTiles()(tileId).getOwningZoneIndex();
+				return static_cast<long>(sph.getZones()(zoneId).getLevel());
+			};
+			long ret = 0;
+			for (IdType i = 0; i < adjacency.getNumberOfTiles(); ++i) {
+				for (auto k = rowMap(i); k < rowMap(i + 1); ++k) {
+					ret = std::max(
+						ret, std::abs(getLevel(i) - getLevel(entries(k))));
+				}
+			}
+			return ret;
+		};
+		auto getTotalVolume = [](const SubpavingType& subpaving) {
+			double ret = 0.0;
+			for (const auto& region : test::getTileRegions(subpaving)) {
+				ret += region.volume();
+			}
+			return ret;
+		};
+
+		// Refining down to a single point next to a level 1 boundary
+		RegionType point{{Ival{30, 31}, Ival{30, 31}}};
+		auto lattice = RegionType{{Ival{0, 64}, Ival{0, 64}}};
+		SubpavingType unbalanced(lattice, {{{2, 2}}});
+		REQUIRE(unbalanced.getLevelBalance() == SubpavingType::noLevelBalance);
+		auto report = unbalanced.refine(RegionDetector{point});
+		REQUIRE(report.balancePasses == 0);
+		REQUIRE(getMaxLevelDifference(unbalanced) == 5);
+		auto numLevels = report.levels.size();
+
+		for (std::size_t k = 1; k <= 2; ++k) {
+			SubpavingType balanced(lattice, {{{2, 2}}});
+			balanced.setLevelBalance(k);
+			report = balanced.refine(RegionDetector{point});
+			REQUIRE(report.balancePasses > 0);
+			// Each pass refines only the tiles found, by one level
+			REQUIRE(report.levels.size() == numLevels + report.balancePasses);
+			REQUIRE(getMaxLevelDifference(balanced) == static_cast<long>(k));
+			REQUIRE(
+				balanced.getNumberOfTiles() > unbalanced.getNumberOfTiles());
+			REQUIRE(getTotalVolume(balanced) == lattice.volume());
+			REQUIRE(balanced.getRefinementDepth() ==
+				unbalanced.getRefinementDepth());
+
+			// The point is still resolved
+			auto tileId = balanced.makeMirrorCopy().findTileId({30, 30});
+			REQUIRE(balanced.makeMirrorCopy().getTileRegion(tileId) == point);
+
+			// Already balanced
+			report = balanced.refine(RegionDetector{point});
+			REQUIRE(report.balancePasses == 0);
+		}
+	}
+
+	SECTION("Refinement Budget")
+	{
+		using BallDetector = refine::BallDetector<TestType, 2,
+			refine::TagPair<refine::Overlap, refine::Overlap>>;
+		auto lattice = RegionType{{Ival{0, 64}, Ival{0, 64}}};
+		auto getTotalVolume = [](const SubpavingType& subpaving) {
+			double ret = 0.0;
+			for (const auto& region : test::getTileRegions(subpaving)) {
+				ret += region.volume();
+			}
+			return ret;
+		};
+
+		// Without limits, the result matches plain refinement
+		SubpavingType plain(lattice, {{{2, 2}}});
+		plain.refine(BallDetector{{20, 40}, 10});
+		SubpavingType budgeted(lattice, {{{2, 2}}});
+		auto report =
+			budgeted.refine(BallDetector{{20, 40}, 10}, RefinementBudget{});
+		REQUIRE(report.budgetBatches > 0);
+		REQUIRE(!report.budgetReached);
+		auto plainRegions = test::getTileRegions(plain);
+		auto budgetedRegions = test::getTileRegions(budgeted);
+		auto byOrigin = [](const RegionType& a, const RegionType& b) {
+			return std::make_pair(a[0].begin(), a[1].begin()) <
+				std::make_pair(b[0].begin(), b[1].begin());
+		};
+		std::sort(plainRegions.begin(), plainRegions.end(), byOrigin);
+		std::sort(budgetedRegions.begin(), budgetedRegions.end(), byOrigin);
+		REQUIRE(budgetedRegions == plainRegions);
+		REQUIRE(budgeted.getRefinementDepth() == plain.getRefinementDepth());
+
+		// The default priority (volume) refines breadth-first
+		RefinementBudget budget;
+		budget.maxTiles = 16;
+		budget.batchSize = 1;
+		SubpavingType uniform(lattice, {{{2, 2}}});
+		report = uniform.refine(RegionDetector{lattice}, budget);
+		REQUIRE(report.budgetReached);
+		REQUIRE(report.budgetBatches == 5);
+		REQUIRE(uniform.getNumberOfTiles() == 16);
+		for (const auto& region : test::getTileRegions(uniform)) {
+			REQUIRE(region.volume() == 256.0);
+		}
+		REQUIRE(uniform.getRefinementDepth() == 2);
+
+		// The highest priorities are refined first
+		budget.maxTiles = 13;
+		SubpavingType nearOrigin(lattice, {{{2, 2}}});
+		report = nearOrigin.refine(test::OriginPriorityDetector{}, budget);
+		REQUIRE(nearOrigin.getNumberOfTiles() == 13);
+		REQUIRE(getTotalVolume(nearOrigin) == lattice.volume());
+		auto sph = nearOrigin.makeMirrorCopy();
+		REQUIRE(sph.getTileRegion(sph.findTileId({0, 0})) ==
+			RegionType{{Ival{0, 4}, Ival{0, 4}}});
+		REQUIRE(sph.getTileRegion(sph.findTileId({63, 63})) ==
+			RegionType{{Ival{32, 64}, Ival{32, 64}}});
+
+		// Larger batches stop where the next tile would not fit
+		budget.maxTiles = 14;
+		budget.batchSize = 8;
+		SubpavingType batched(lattice, {{{2, 2}}});
+		Prolongation<typename SubpavingType::MemorySpace> prolongation;
+		report = batched.refine(RegionDetector{lattice}, budget, prolongation);
+		REQUIRE(report.budgetReached);
+		REQUIRE(batched.getNumberOfTiles() == 13);
+		REQUIRE(prolongation.getParentTileIds().size() == 13);
+
+		// Only the axes the detector enables count against the budget (away
+		// from the origin, only the first)
+		budget.maxTiles = 5;
+		auto shifted = RegionType{{Ival{64, 128}, Ival{0, 64}}};
+		SubpavingType slabs(shifted, {{{2, 2}}});
+		report = slabs.refine(test::FirstAxisDetector{}, budget);
+		REQUIRE(report.budgetReached);
+		REQUIRE(slabs.getNumberOfTiles() == 5);
+		for (const auto& region : test::getTileRegions(slabs)) {
+			REQUIRE(region[1] == shifted[1]);
+		}
+
+		// The memory stays within its limit
+		SubpavingType limited(lattice, {{{2, 2}}});
+		budget = RefinementBudget{};
+		budget.maxDeviceMemory = limited.getDeviceMemorySize() + 2048;
+		report = limited.refine(RegionDetector{lattice}, budget);
+		REQUIRE(report.budgetReached);
+		REQUIRE(limited.getNumberOfTiles() > 1);
+		REQUIRE(limited.getDeviceMemorySize() <= budget.maxDeviceMemory);
+		REQUIRE(getTotalVolume(limited) == lattice.volume());
+
+		// The level balance could not be kept within the budget
+		limited.setLevelBalance(1);
+		REQUIRE_THROWS_AS(limited.refine(RegionDetector{lattice}, budget),
+			std::invalid_argument);
+		limited.setLevelBalance(SubpavingType::noLevelBalance);
+
+		budget.batchSize = 0;
+		REQUIRE_THROWS_AS(limited.refine(RegionDetector{lattice}, budget),
+			std::invalid_argument);
+	}
+
+	SECTION("Item Data")
+	{
+		using DataSubpaving = Subpaving<TestType, 2, void, test::TileValue>;
+		DataSubpaving dsp({{Ival{0, 8}, Ival{0, 8}}}, {{{2, 2}, {4, 4}}});
+		REQUIRE(dsp.getItemDataInit() == ItemDataInit::copyParent);
+
+		// Mark each tile with its origin
+		auto marker = [](const RegionType& region) {
+			auto origin = region.getOrigin();
+			return static_cast<double>(origin[0] * 8 + origin[1]);
+		};
+		auto setMarkers = [&]() {
+			auto sph = dsp.makeMirrorCopy();
+			auto itemData = sph.getItemData();
+			for (IdType i = 0; i < sph.getNumberOfTiles(); ++i) {
+				itemData(i) = {marker(sph.getTileRegion(i)), 1};
+			}
+			deep_copy(dsp.getItemData(), itemData);
+		};
+		// Count the tiles whose data is not the marker of the given region
+		auto checkData = [&](const auto& getRegion) {
+			auto sph = dsp.makeMirrorCopy();
+			auto itemData = sph.getItemData();
+			IdType errors = 0;
+			for (IdType i = 0; i < sph.getNumberOfTiles(); ++i) {
+				auto region = sph.getTileRegion(i);
+				if (itemData(i).value != marker(getRegion(region)) ||
+					itemData(i).count != 1) {
+					++errors;
+				}
+			}
+			return errors;
+		};
+		auto sameRegion = [](const RegionType& region) { return region; };
+		auto quadrant = [](const RegionType& region) {
+			auto origin = region.getOrigin();
+			return RegionType{{Ival{origin[0] / 4 * 4, 8},
+				Ival{origin[1] / 4 * 4, 8}}};
+		};
+
+		dsp.refine(RegionDetector{dsp.getLatticeRegion(), 1});
+		REQUIRE(dsp.getNumberOfTiles() == 4);
+		setMarkers();
+		REQUIRE(checkData(sameRegion) == 0);
+
+		// The data of each tile can be reached through the subpaving
+		auto subpaving = dsp;
+		Kokkos::parallel_for(
+			dsp.getNumberOfTiles(), KOKKOS_LAMBDA(IdType i) {
+				auto data = subpaving.getTileData(i);
+				data.count = 2;
+				subpaving.setTileData(i, data);
+			});
+		Kokkos::fence();
+		REQUIRE(dsp.makeMirrorCopy().getTileData(3).count == 2);
+		Kokkos::parallel_for(
+			dsp.getNumberOfTiles(),
+			KOKKOS_LAMBDA(IdType i) { subpaving.getTileData(i).count = 1; });
+		Kokkos::fence();
+		REQUIRE(checkData(sameRegion) == 0);
+
+		// The data of the tiles is copied into those refined from them
+		dsp.refine(RegionDetector{dsp.getLatticeRegion()});
+		REQUIRE(dsp.getNumberOfTiles() == 64);
+		REQUIRE(checkData(quadrant) == 0);
+
+		// The data follows the tiles when they are reordered, copied, or
+		// stored
+		setMarkers();
+		dsp.reorderTiles(SpaceFillingCurve::hilbert);
+		REQUIRE(checkData(sameRegion) == 0);
+		auto path = (std::filesystem::temp_directory_path() /
+			"plsm_unittest_item_data.plsm")
+						.string();
+		dsp.save(path);
+		DataSubpaving loaded;
+		loaded.load(path);
+		std::remove(path.c_str());
+		REQUIRE(loaded.getNumberOfTiles() == 64);
+		auto itemData = dsp.makeMirrorCopy().getItemData();
+		auto loadedItemData = loaded.makeMirrorCopy().getItemData();
+		IdType errors = 0;
+		for (IdType i = 0; i < 64; ++i) {
+			if (loadedItemData(i).value != itemData(i).value) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+		// Files without item data are not loaded as a subpaving with it
+		sp.save(path);
+		REQUIRE_THROWS_AS(loaded.load(path), std::runtime_error);
+		std::remove(path.c_str());
+
+		// Merged tiles keep the data of the first of them
+		dsp.coarsen(RegionDetector{dsp.getLatticeRegion(), 1});
+		REQUIRE(dsp.getNumberOfTiles() == 4);
+		REQUIRE(checkData(sameRegion) == 0);
+
+		// Reset the data of tiles produced by refinement
+		dsp.setItemDataInit(ItemDataInit::reset);
+		dsp.refine(RegionDetector{dsp.getLatticeRegion()});
+		auto sph = dsp.makeMirrorCopy();
+		for (IdType i = 0; i < sph.getNumberOfTiles(); ++i) {
+			if (sph.getItemData()(i).value != 0.0 ||
+				sph.getItemData()(i).count != 0) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+	}
+
+	SECTION("Tile Attributes")
+	{
+		TileAttributes<DefaultMemSpace> attributes{sp.getNumberOfTiles()};
+		auto amount = attributes.template add<double*>("amount");
+		auto concentrations = attributes.template add<double**>(
+			"concentrations", AttributeTransfer::intensive, 2);
+		REQUIRE(amount.extent(0) == 1);
+		REQUIRE(concentrations.extent(1) == 2);
+		REQUIRE(attributes.contains("amount"));
+		REQUIRE(attributes.getNames() ==
+			std::vector<std::string>{"amount", "concentrations"});
+		REQUIRE_THROWS_AS(attributes.template add<double*>("amount"),
+			std::invalid_argument);
+		REQUIRE_THROWS_AS(attributes.template get<float*>("amount"),
+			std::invalid_argument);
+		REQUIRE_THROWS_AS(attributes.template get<double*>("volume"),
+			std::invalid_argument);
+		sp.setTileAttributes(&attributes);
+		REQUIRE(sp.getTileAttributes() == &attributes);
+
+		Kokkos::parallel_for(
+			1, KOKKOS_LAMBDA(IdType i) {
+				amount(i) = 64.0;
+				concentrations(i, 0) = 3.0;
+				concentrations(i, 1) = 5.0;
+			});
+
+		auto getAmount = [](const auto& table) {
+			return table.template get<double*>("amount");
+		};
+		auto getConcentrations = [](const auto& table) {
+			return table.template get<double**>("concentrations");
+		};
+		// Sum of each attribute (times tile volume if intensive)
+		auto getTotals = [&]() {
+			auto sph = sp.makeMirrorCopy();
+			auto table = attributes.makeMirrorCopy();
+			auto amountMirror = getAmount(table);
+			auto concMirror = getConcentrations(table);
+			std::array<double, 3> ret{};
+			for (IdType i = 0; i < sph.getNumberOfTiles(); ++i) {
+				auto volume =
+					static_cast<double>(sph.getTileRegion(i).volume());
+				ret[0] += amountMirror(i);
+				ret[1] += concMirror(i, 0) * volume;
+				ret[2] += concMirror(i, 1) * volume;
+			}
+			return ret;
+		};
+		auto marker = [](const RegionType& region) {
+			auto origin = region.getOrigin();
+			return static_cast<double>(origin[0] * 8 + origin[1]);
+		};
+
+		// Refined tiles share the amount and keep the concentrations
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		REQUIRE(sp.getNumberOfTiles() == 64);
+		REQUIRE(attributes.getNumberOfTiles() == 64);
+		auto table = attributes.makeMirrorCopy();
+		auto amountMirror = getAmount(table);
+		auto concMirror = getConcentrations(table);
+		REQUIRE(amountMirror.extent(0) == 64);
+		IdType errors = 0;
+		for (IdType i = 0; i < 64; ++i) {
+			if (amountMirror(i) != Approx(1.0) || concMirror(i, 0) != 3.0 ||
+				concMirror(i, 1) != 5.0) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+
+		// Mark each tile with its origin, and follow the marks through
+		// reordering
+		amount = getAmount(attributes);
+		concentrations = getConcentrations(attributes);
+		auto subpaving = sp;
+		Kokkos::parallel_for(
+			64, KOKKOS_LAMBDA(IdType i) {
+				auto origin = subpaving.getTileRegion(i).getOrigin();
+				amount(i) = static_cast<double>(origin[0] * 8 + origin[1]);
+				concentrations(i, 0) = static_cast<double>(origin[0]);
+			});
+		auto totals = getTotals();
+		sp.reorderTiles(SpaceFillingCurve::hilbert);
+		auto sph = sp.makeMirrorCopy();
+		amountMirror = getAmount(attributes.makeMirrorCopy());
+		for (IdType i = 0; i < 64; ++i) {
+			if (amountMirror(i) != marker(sph.getTileRegion(i))) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+
+		// Merged tiles add the amounts and average the concentrations
+		sp.coarsen(RegionDetector{sp.getLatticeRegion(), 1});
+		REQUIRE(sp.getNumberOfTiles() == 4);
+		REQUIRE(attributes.getNumberOfTiles() == 4);
+		auto newTotals = getTotals();
+		for (std::size_t k = 0; k < totals.size(); ++k) {
+			REQUIRE(newTotals[k] == Approx(totals[k]));
+		}
+		sph = sp.makeMirrorCopy();
+		concMirror = getConcentrations(attributes.makeMirrorCopy());
+		for (IdType i = 0; i < 4; ++i) {
+			// Mean of the first coordinates of the origins in the quadrant
+			auto origin = sph.getTileRegion(i).getOrigin();
+			if (concMirror(i, 0) !=
+					Approx(static_cast<double>(origin[0]) + 1.5) ||
+				concMirror(i, 1) != Approx(5.0)) {
+				++errors;
+			}
+		}
+		REQUIRE(errors == 0);
+
+		// Every refinement path prolongates the attributes
+		RefinementBudget budget;
+		budget.maxTiles = 19;
+		sp.refine(RegionDetector{sp.getLatticeRegion()}, budget);
+		REQUIRE(sp.getNumberOfTiles() == 19);
+		REQUIRE(attributes.getNumberOfTiles() == 19);
+		newTotals = getTotals();
+		for (std::size_t k = 0; k < totals.size(); ++k) {
+			REQUIRE(newTotals[k] == Approx(totals[k]));
+		}
+
+		// Loading resets the attributes for the loaded tiles
+		auto path = (std::filesystem::temp_directory_path() /
+			"plsm_unittest_tile_attributes.bin")
+						.string();
+		SubpavingType saved(sp.getLatticeRegion(), {{{2, 2}, {4, 4}}});
+		saved.save(path);
+		sp.load(path);
+		std::filesystem::remove(path);
+		REQUIRE(attributes.getNumberOfTiles() == 1);
+		REQUIRE(getAmount(attributes.makeMirrorCopy())(0) == 0.0);
+
+		// Attributes for other tiles are rejected
+		TileAttributes<DefaultMemSpace> other{4};
+		REQUIRE_THROWS_AS(sp.setTileAttributes(&other), std::invalid_argument);
+		REQUIRE(sp.getTileAttributes() == &attributes);
+
+		// Unregistered attributes are left as they are
+		sp.setTileAttributes(nullptr);
+		sp.refine(RegionDetector{sp.getLatticeRegion()});
+		REQUIRE(attributes.getNumberOfTiles() == 1);
+
+		attributes.remove("amount");
+		REQUIRE(!attributes.contains("amount"));
+		REQUIRE(attributes.contains("concentrations"));
+	}
+}
@@ -11,16 +11,30 @@ TEMPLATE_LIST_TEST_CASE("Tile Basic", "[Tile][template]", test::IntTypes)
 	TileType t;
 	REQUIRE(!t.hasOwningZone());
 	REQUIRE(!t.hasData());
+#if !defined(PLSM_USE_COMPACT_TILES)
 	REQUIRE(t.getRegion().empty());
+#endif
 
 	using Ival = typename RegionType::IntervalType;
 	RegionType r1{Ival{12}, Ival{8}};
 	TileType t1{r1, 0};
 	REQUIRE(t1.hasOwningZone());
 	REQUIRE(t1.getOwningZoneIndex() == 0);
+#if defined(PLSM_USE_COMPACT_TILES)
+	// The region is looked up through the owning zone instead
+	REQUIRE(sizeof(TileType) == 2 * sizeof(IdType));
+	REQUIRE(sizeof(Tile<RegionType, void>) == sizeof(IdType));
+#else
 	REQUIRE(!t1.getRegion().empty());
+#endif
 	REQUIRE(!t1.hasData());
 	t1.setData(245);
 	REQUIRE(t1.hasData());
 	REQUIRE(t1.getData() == 245);
+
+	// Other data is value-initialized
+	Tile<RegionType, SpaceVector<double, 2>> t2{r1, 0};
+	REQUIRE(t2.getData()[0] == 0.0);
+	t2.setData({1.0, 2.0});
+	REQUIRE(t2.getData()[1] == 2.0);
 }
@@ -11,9 +11,23 @@ TEMPLATE_LIST_TEST_CASE("Zone Basic", "[Zone][template]", test::IntTypes)
 	ZoneType zone;
 	REQUIRE(!zone.hasTile());
 	REQUIRE(!zone.hasParent());
-	REQUIRE(zone.getRegion().empty());
 	REQUIRE(zone.getSubZoneIndices().empty());
 
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	ZoneType zone1{0, 0};
+	REQUIRE(!zone1.hasTile());
+	REQUIRE(zone1.getLocalIndex() == 0);
+	REQUIRE(!zone1.hasParent());
+
+	ZoneType zone2{3, 1, 0};
+	REQUIRE(!zone2.hasTile());
+	REQUIRE(zone2.getLocalIndex() == 3);
+	REQUIRE(zone2.getSubZoneIndices().empty());
+	zone2.setSubZoneAxes(2);
+	REQUIRE(zone2.getSubZoneAxes() == 2);
+#else
+	REQUIRE(zone.getRegion().empty());
+
 	using Ival = typename RegionType::IntervalType;
 	RegionType r1{Ival{12}, Ival{8}};
 	ZoneType zone1{r1, 0};
@@ -25,8 +39,11 @@ TEMPLATE_LIST_TEST_CASE("Zone Basic", "[Zone][template]", test::IntTypes)
 	REQUIRE(!zone2.hasTile());
 	REQUIRE(!zone2.getRegion().empty());
 	REQUIRE(zone2.getSubZoneIndices().empty());
+#endif
 	REQUIRE(zone2.hasParent());
 	REQUIRE(zone2.getParentIndex() == 0);
+	zone2.setParentIndex(2);
+	REQUIRE(zone2.getParentIndex() == 2);
 	zone2.setTileIndex(1);
 	REQUIRE(zone2.hasTile());
 	REQUIRE(zone2.getTileIndex() == 1);
@@ -35,4 +52,21 @@ TEMPLATE_LIST_TEST_CASE("Zone Basic", "[Zone][template]", test::IntTypes)
 	zone2.setSubZoneIndices(ival);
 	REQUIRE(zone2.getSubZoneIndices() == ival);
 	REQUIRE(zone2.getSubZoneRange().interval() == ival);
+
+#if defined(PLSM_USE_PACKED_ZONES)
+	// A packed zone has either sub-zones or a tile
+	REQUIRE(!zone2.hasTile());
+	REQUIRE(zone2.getLevel() == 1);
+	zone2.setTileIndex(5);
+	REQUIRE(zone2.hasTile());
+	REQUIRE(zone2.getTileIndex() == 5);
+	REQUIRE(zone2.getSubZoneIndices().empty());
+	zone2.removeTile();
+	REQUIRE(!zone2.hasTile());
+	REQUIRE(zone2.getTileIndex() == invalid<IdType>);
+#if defined(PLSM_USE_IMPLICIT_ZONE_REGIONS)
+	REQUIRE(zone2.getSubZoneAxes() == 2);
+	REQUIRE(sizeof(ZoneType) == 4 * sizeof(IdType));
+#endif
+#endif
 }